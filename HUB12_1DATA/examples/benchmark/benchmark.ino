@@ -0,0 +1,132 @@
+// Microbenchmarks del pipeline de render y refresco.
+// Imprime CSV por Serial: una línea por (operación, geometría, serpentina, doble buffer).
+//
+//   bench,op,panelsX,panelsY,serp,dbl,iters,ns_per_op,bytes_per_op
+//
+// bytes_per_op = bytes de datos de panel que produce la operación (scan construido,
+// bits desplazados, framebuffer cubierto); 0 cuando no aplica.
+//
+// buildScan y refresh miden un tablero de ajedrez: refresh() no carga las filas
+// sin LEDs, así que sobre una pantalla vacía no desplazaría nada. bytes_per_op
+// de refresh cuenta solo las filas con LEDs (las que de verdad se desplazan).
+//
+// En el ESP32 mide con esp_timer_get_time(). En PC usa micros() del backend host,
+// con el panel virtual desactivado (backend nulo):
+//   g++ -std=c++11 -O2 -x c++ -I../../src benchmark.ino -x none ../../src/HUB12_1DATA.cpp ../../src/HUB12_host.cpp
+#include <HUB12_1DATA.h>
+#include <fonts/SystemFont5x7.h>
+
+HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+
+static const uint8_t kGeom[][2] = { {1,1}, {2,1}, {4,2}, {6,3}, {8,4} };
+static const uint32_t kMinUs = 50000;   // tiempo mínimo de medición por operación
+
+static int64_t nowUs() {
+#if defined(ESP32)
+  return esp_timer_get_time();
+#else
+  return (int64_t)micros();
+#endif
+}
+
+enum Op { OP_BUILDSCAN, OP_REFRESH, OP_DRAWTEXT, OP_DRAWTEXTSCALED, OP_FILLRECT,
+          OP_FILLTRIANGLE, OP_FILLCIRCLE, OP_MARQUEETICK, OP_COUNT };
+static const char* kOpName[OP_COUNT] = { "buildScan", "refresh", "drawText", "drawTextScaled",
+                                         "fillRect", "fillTriangle", "fillCircle", "marqueeTick" };
+
+static void runOp(HUB12_1DATA& d, Op op, uint32_t i) {
+  int w = d.width(), h = d.height();
+  bool on = (i & 1) == 0;
+  switch (op) {
+    case OP_BUILDSCAN:      d.invalidate(); d.update(); break;
+    case OP_REFRESH:        d.refresh(); break;
+    case OP_DRAWTEXT:       d.drawText(1, 1, "HUB12 0123456789", on, 1); break;
+    case OP_DRAWTEXTSCALED: d.drawTextScaled(0, 0, "12:45", 2, on, 1); break;
+    case OP_FILLRECT:       d.fillRect(1, 1, w - 2, h - 2, on); break;
+    case OP_FILLTRIANGLE:   d.fillTriangle(0, 0, w - 1, h / 2, w / 3, h - 1, on); break;
+    case OP_FILLCIRCLE:     d.fillCircle(w / 2, h / 2, h / 2 - 1, on); break;
+    case OP_MARQUEETICK:    d.marqueeTick(true); break;
+    default: break;
+  }
+}
+
+// Tablero de ajedrez: todas las filas del scan tienen LEDs encendidos
+static void drawChecker(HUB12_1DATA& d) {
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) d.drawPixel(x, y, ((x ^ y) & 1) != 0);
+}
+
+static uint32_t bytesPerOp(HUB12_1DATA& d, Op op) {
+  uint32_t scanBytes = (uint32_t)d.width() * d.height() / 8;
+  uint32_t shifted = 0;
+  switch (op) {
+    case OP_REFRESH:
+      for (uint8_t r = 0; r < 4; r++)
+        if (d.rowLit(r)) shifted += scanBytes / 4;
+      return shifted;
+    case OP_BUILDSCAN:
+    case OP_MARQUEETICK: return scanBytes;
+    case OP_FILLRECT:    return (uint32_t)(d.width() - 2) * (d.height() - 2) / 8;
+    default:             return 0;
+  }
+}
+
+static void bench(uint8_t px, uint8_t py, bool serp, bool dbl) {
+  // En heap, no en el stack del loopTask: el objeto ocupa unos KB
+  HUB12_1DATA* dp = new HUB12_1DATA(pins, px, py, serp);
+  HUB12_1DATA& d = *dp;
+  d.setDoubleBuffer(dbl);
+  if (!d.begin()) { delete dp; return; }
+  d.setFont(SystemFont5x7);
+  d.setOnTimeUs(0);   // refresh(): medir solo shift/latch
+  d.marqueeStart(0, 0, d.width(), d.height(), "MARQUESINA DE PRUEBA 0123456789", 1, 0);
+  // Contenido para buildScan/refresh (las primeras); con doble buffer, en los dos
+  drawChecker(d);
+  d.update();
+  drawChecker(d);
+
+  for (int o = 0; o < OP_COUNT; o++) {
+    Op op = (Op)o;
+    uint32_t iters = 0, batch = 1;
+    int64_t t0 = nowUs(), el = 0;
+    while (el < (int64_t)kMinUs) {
+      for (uint32_t k = 0; k < batch; k++) runOp(d, op, iters + k);
+      iters += batch;
+      batch *= 2;
+      el = nowUs() - t0;
+    }
+
+    double ns = (double)el * 1000.0 / (double)iters;
+    Serial.print("bench,"); Serial.print(kOpName[op]);
+    Serial.print(','); Serial.print((int)px); Serial.print(','); Serial.print((int)py);
+    Serial.print(','); Serial.print((int)serp); Serial.print(','); Serial.print((int)dbl);
+    Serial.print(','); Serial.print((unsigned long)iters);
+    Serial.print(','); Serial.print(ns, 1);
+    Serial.print(','); Serial.println((unsigned long)bytesPerOp(d, op));
+  }
+  delete dp;   // end() en el destructor
+}
+
+void setup() {
+  Serial.begin(115200);
+#if !defined(ARDUINO)
+  HUB12Host.setEnabled(false);   // backend nulo: no emular el panel
+#endif
+  Serial.println("bench,op,panelsX,panelsY,serp,dbl,iters,ns_per_op,bytes_per_op");
+  for (uint8_t g = 0; g < sizeof(kGeom) / sizeof(kGeom[0]); g++)
+    for (int serp = 0; serp < 2; serp++)
+      for (int dbl = 0; dbl < 2; dbl++)
+        bench(kGeom[g][0], kGeom[g][1], serp, dbl);
+  Serial.println("done");
+}
+
+void loop() {
+  delay(1000);
+}
+
+#if !defined(ARDUINO)
+int main() {
+  setup();
+  return 0;
+}
+#endif
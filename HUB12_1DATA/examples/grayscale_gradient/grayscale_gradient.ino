@@ -0,0 +1,32 @@
+#include <Arduino.h>
+#include <HUB12_1DATA.h>
+#include <fonts/SystemFont5x7.h>
+
+// Escala de grises de 3 bits (8 niveles) por BCM: degradado horizontal arriba y
+// texto a medio brillo abajo. El ciclo de refresco pasa de 4 a 12 shifts.
+
+HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+HUB12_1DATA d(pins, 1, 1, false);
+
+uint8_t ramp[32 * 8];
+
+void setup() {
+  d.setGrayscale(3);            // antes de begin()
+  d.begin();
+  d.setOnTimeUs(600);
+  d.setFont(SystemFont5x7);
+
+  for (int y = 0; y < 8; y++)
+    for (int x = 0; x < 32; x++) ramp[y * 32 + x] = (uint8_t)(x * 8 + 7);
+  d.drawGrayBitmap(0, 0, ramp, 32, 8);
+
+  d.setDrawLevel(2);            // 2/7 del brillo máximo
+  d.drawText(1, 9, "GRIS");
+  d.update();
+
+  d.startAutoRefresh(6000);     // mínimo 4 * (600 + 75 * 7) = 4500 us con 3 bits
+}
+
+void loop() {
+  delay(10);
+}
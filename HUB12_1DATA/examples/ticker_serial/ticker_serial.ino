@@ -0,0 +1,29 @@
+#include <Arduino.h>
+#include <HUB12_1DATA.h>
+#include <fonts/SystemFont5x7.h>
+
+// Ticker alimentado por el puerto serie: lo que llega por Serial entra por la
+// derecha del panel. El buffer es fijo (64 caracteres); si el feed va más rápido
+// que el scroll, Serial lo retiene hasta que haya lugar.
+
+HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+HUB12_1DATA d(pins, 2, 1, false);
+HUB12_1DATA::Ticker ticker;
+
+void setup() {
+  Serial.begin(115200);
+  d.begin();
+  d.setOnTimeUs(600);
+  d.setFont(SystemFont5x7);
+  d.startAutoRefresh(5000);
+
+  ticker.attach(d);
+  ticker.start(0, 0, d.width(), 16, 64, 1, 30);
+  ticker.setSource(&Serial);
+  ticker.print("Esperando datos... ");
+}
+
+void loop() {
+  ticker.tick();   // lee Serial, corre 1 px y llama update() si algo se movió
+  delay(1);
+}
@@ -0,0 +1,61 @@
+// buildScan() por bytes con tablas contra el build por pixel de 1.0.0.
+// Mismo contenido (mitad de los pixeles encendidos, pseudoaleatorio) en varias
+// geometrías; el build de 1.0.0 se reproduce tal cual fuera de la librería
+// (recorre todos los pixeles y pone cada bit encendido en su byte del scan).
+// El nuevo se mide con invalidate() + update(): todas las filas sucias.
+#include "bench_util.h"
+
+// ---------- Build de 1.0.0 ----------
+static int legacyBitIndex(int x, int y) {
+  int pos8 = (x >> 3) & 3;
+  int x8   = x & 7;
+  int band = y & 12;
+  int sub = (band == 12) ? 0 : (band == 8) ? 1 : (band == 4) ? 2 : 3;
+  return pos8 * 32 + sub * 8 + x8;
+}
+
+static void legacyBuildScan(const HUB12_1DATA& d, uint8_t panelsX, bool serp, uint8_t* out,
+                            uint32_t scanBytes) {
+  uint32_t bytesPerR = scanBytes / 4;
+  memset(out, 0, scanBytes);
+  for (int gy = 0; gy < (int)d.height(); gy++) {
+    for (int gx = 0; gx < (int)d.width(); gx++) {
+      if (!d.getPixel(gx, gy)) continue;
+      uint8_t px = gx / 32, py = gy / 16;
+      int lx = gx % 32, ly = gy % 16;
+      uint8_t panelIdx = py * panelsX + px;
+      if (serp && (py & 1)) { panelIdx = py * panelsX + (panelsX - 1 - px); lx = 31 - lx; }
+      int bit = legacyBitIndex(lx, ly);
+      out[(uint32_t)(ly & 3) * bytesPerR + (uint32_t)panelIdx * 16 + (bit >> 3)] |= 1 << (7 - (bit & 7));
+    }
+  }
+}
+
+int main() {
+  static const uint8_t kGeom[][2] = { {1,1}, {2,1}, {4,2}, {6,3}, {8,4} };
+  HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+  HUB12Host.setEnabled(false);   // solo la librería
+
+  printf("%-5s %-4s %12s %12s %8s\n", "geom", "serp", "1.0.0 (us)", "tablas (us)", "x");
+  for (const auto& g : kGeom) {
+    for (int serp = 0; serp < 2; serp++) {
+      HUB12_1DATA d(pins, g[0], g[1], serp);
+      if (!d.begin()) return 1;
+      uint32_t st = 12345;
+      for (int y = 0; y < d.height(); y++)
+        for (int x = 0; x < d.width(); x++) {
+          st = st * 1103515245u + 12345u;
+          d.drawPixel(x, y, (st >> 16) & 1);
+        }
+      d.update();
+
+      uint32_t scanBytes = 64u * g[0] * g[1];
+      uint8_t* ref = (uint8_t*)malloc(scanBytes);
+      double tOld = timeIt([&] { legacyBuildScan(d, g[0], serp, ref, scanBytes); });
+      double tNew = timeIt([&] { d.invalidate(); d.update(); });
+      printf("%dx%-3d %-4d %12.2f %12.3f %8.1f\n", g[0], g[1], serp, tOld, tNew, tOld / tNew);
+      free(ref);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,33 @@
+// Geometría fija del README: update() con todas las filas sucias (invalidate() +
+// update()) en HUB12<PX, PY, HUB12_SERPENTINE> contra el HUB12_1DATA
+// equivalente, con la pantalla llena. Panel virtual apagado.
+#include "bench_util.h"
+#include <HUB12.h>
+
+static void fill(HUB12_1DATA& d) {
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) d.drawPixel(x, y, ((x >> 1) ^ y) & 1);
+  d.update();
+}
+
+template <uint8_t PX, uint8_t PY>
+static void row() {
+  HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+  static HUB12<PX, PY, HUB12_SERPENTINE> t(pins);
+  HUB12_1DATA r(pins, PX, PY, true);
+  if (!t.begin() || !r.begin()) return;
+  fill(t);
+  fill(r);
+  double tt = timeIt([&] { t.invalidate(); t.update(); });
+  double tr = timeIt([&] { r.invalidate(); r.update(); });
+  printf("%dx%-3d %-14.2f %-14.2f %.2fx\n", PX, PY, tt, tr, tr / tt);
+}
+
+int main() {
+  HUB12Host.setEnabled(false);   // solo la librería
+  printf("%-5s %-14s %-14s %s\n", "geom", "HUB12<> (us)", "1DATA (us)", "ganancia");
+  row<1, 1>();
+  row<4, 2>();
+  row<4, 4>();
+  return 0;
+}
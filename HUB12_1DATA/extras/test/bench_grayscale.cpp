@@ -0,0 +1,48 @@
+// Tabla de escala de grises del README: onTimeUs 600, 8 paneles 4x2.
+// Por profundidad: unidad, filas cargadas por ciclo, tiempo ON medido en el
+// panel virtual para un LED de nivel 1 y otro de nivel máximo, y CPU de un
+// update() completo (invalidate() + update()) con el panel virtual apagado.
+// Los tiempos ON van con el reloj real apagado (solo delayMicroseconds()): son
+// los del firmware, sin el costo del emulador.
+#include "bench_util.h"
+#include <vector>
+
+int main() {
+  HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+
+  printf("%-4s %-7s %-11s %-12s %-18s %s\n", "bits", "niveles", "unidad (us)", "shifts/ciclo",
+         "ON nivel 1/max (us)", "update() (us CPU)");
+  for (uint8_t bits = 1; bits <= 4; bits++) {
+    HUB12_1DATA d(pins, 4, 2, false);
+    if (bits > 1) d.setGrayscale(bits);
+    if (!d.begin()) return 1;
+    d.setOnTimeUs(600);
+
+    // degradé en toda la pantalla; (0,0) a nivel 1 y (1,0) al máximo
+    int W = d.width(), H = d.height();
+    std::vector<uint8_t> g(W * H);
+    for (int i = 0; i < W * H; i++) g[i] = (uint8_t)((i * 37) % 256);
+    d.drawGrayBitmap(0, 0, g.data(), W, H);
+    d.setDrawLevel(1);
+    d.drawPixel(0, 0, true);
+    d.setDrawLevel(d.maxLevel());
+    d.drawPixel(1, 0, true);
+    d.update();
+
+    HUB12Host.setEnabled(true);
+    hostSetRealClock(false);
+    HUB12Host.clearImage();
+    d.refresh();
+    uint32_t rows = HUB12Host.rowsShown();
+    d.refreshRow();   // cierra la ranura de la última fila
+    uint32_t on1 = HUB12Host.onTimeUs(0, 0), onMax = HUB12Host.onTimeUs(1, 0);
+    hostSetRealClock(true);
+
+    HUB12Host.setEnabled(false);   // solo la librería
+    double upd = timeIt([&] { d.invalidate(); d.update(); });
+
+    printf("%-4d %-7d %-11u %-12u %4u / %-11u %.2f\n", bits, d.maxLevel() + 1,
+           600u / d.maxLevel(), rows, on1, onMax, upd);
+  }
+  return 0;
+}
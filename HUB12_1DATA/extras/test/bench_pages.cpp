@@ -0,0 +1,31 @@
+// Páginas del README: 4x4 paneles con texto. Tamaño de la página cruda y en
+// RLE, y costo de showPage() de cada una contra un update() completo
+// (invalidate() + update()) del mismo contenido. Panel virtual apagado.
+#include "bench_util.h"
+#include <fonts/SystemFont5x7.h>
+
+int main() {
+  HUB12_1DATA::Pins pins = {36,1,2,41,40,39};
+  HUB12Host.setEnabled(false);   // solo la librería
+
+  static const uint8_t kGeom[][2] = { {1,1}, {4,2}, {4,4} };
+  printf("%-5s %-12s %-14s %-16s %-14s %s\n", "geom", "update (us)", "cruda (us)", "cruda (B)",
+         "RLE (us)", "RLE (B)");
+  for (const auto& g : kGeom) {
+    HUB12_1DATA d(pins, g[0], g[1], false);
+    if (!d.begin()) return 1;
+    d.setFont(SystemFont5x7);
+    // una línea de texto cada 16 px, como un cartel de varias filas
+    for (int y = 4; y + 7 <= d.height(); y += 16) d.drawText(2, y, "HOLA 123");
+    d.update();
+    int raw = d.bakePage(false), rle = d.bakePage(true);
+    if (raw < 0 || rle < 0) return 1;
+
+    double tUpd = timeIt([&] { d.invalidate(); d.update(); });
+    double tRaw = timeIt([&] { d.showPage(raw); });
+    double tRle = timeIt([&] { d.showPage(rle); });
+    printf("%dx%-3d %-12.2f %-14.3f %-16u %-14.3f %u\n", g[0], g[1], tUpd, tRaw, d.pageBytes(raw),
+           tRle, d.pageBytes(rle));
+  }
+  return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+// Helpers de los benchmarks de PC: reloj en us y timeIt() (mejor de 5 tandas).
+#include <HUB12_1DATA.h>
+#include <chrono>
+
+static inline double nowUs() {
+  using namespace std::chrono;
+  return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Repite fn hasta juntar minUs y devuelve us por llamada; el mejor de 5 tandas
+template <typename F>
+static double timeIt(F fn, double minUs = 20000) {
+  double best = 1e30;
+  for (int rep = 0; rep < 5; rep++) {
+    uint32_t n = 0, batch = 1;
+    double t0 = nowUs(), el = 0;
+    while (el < minUs) {
+      for (uint32_t i = 0; i < batch; i++) fn();
+      n += batch;
+      batch *= 2;
+      el = nowUs() - t0;
+    }
+    if (el / n < best) best = el / n;
+  }
+  return best;
+}
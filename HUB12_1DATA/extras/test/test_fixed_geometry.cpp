@@ -0,0 +1,93 @@
+// HUB12<PanelsX, PanelsY, Layout, Bits> contra el HUB12_1DATA equivalente en el
+// panel virtual: los dos reciben los mismos dibujos al azar y, frame a frame,
+//  - rowLit() (conteos del limitador) es igual en las 4 filas;
+//  - cada pocos frames, un ciclo de refresh() deja el mismo tiempo ON en cada
+//    pixel (en grises eso compara el nivel) y lo encendido es lo dibujado.
+// Geometrías lineales y serpentina, 1 a 4 bits, 1 y 2 cadenas, doble buffer y
+// modo nativo.
+#include "test_util.h"
+#include <HUB12.h>
+#include <vector>
+
+enum Mode { PLAIN, DOUBLE_BUFFER, NATIVE, CHAINS2, MODES };
+static const char* kModeName[MODES] = { "simple", "doble buffer", "nativo", "2 cadenas" };
+
+// Tiempo ON de cada pixel después de un ciclo
+static std::vector<uint32_t> onTimes(HUB12_1DATA& d) {
+  HUB12Host.clearImage();
+  d.refresh();
+  std::vector<uint32_t> img(d.width() * d.height());
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) img[y * d.width() + x] = HUB12Host.onTimeUs(x, y);
+  return img;
+}
+
+static void setup(HUB12_1DATA& d, Mode m, uint8_t bits) {
+  if (bits > 1) d.setGrayscale(bits);
+  if (m == DOUBLE_BUFFER) d.setDoubleBuffer(true);
+  if (m == NATIVE) d.setPanelNative(true);
+  d.setOnTimeUs(100);
+}
+
+template <uint8_t PX, uint8_t PY, HUB12Layout L, uint8_t Bits>
+static void compare(Mode m) {
+  if (m == NATIVE && Bits > 1) return;               // nativo es solo monocromo
+  if (m == CHAINS2 && (PX * PY) % 2) return;         // bloques iguales por cadena
+  char name[48];
+  snprintf(name, sizeof(name), "%dx%d %s %db %s", PX, PY, L == HUB12_SERPENTINE ? "serp" : "lin",
+           Bits, kModeName[m]);
+
+  HUB12<PX, PY, L, Bits>* t;
+  HUB12_1DATA* r;
+  if (m == CHAINS2) {
+    t = new HUB12<PX, PY, L, Bits>(testPinsMulti(2));
+    r = new HUB12_1DATA(testPinsMulti(2), PX, PY, L == HUB12_SERPENTINE);
+  } else {
+    t = new HUB12<PX, PY, L, Bits>(kTestPins);
+    r = new HUB12_1DATA(kTestPins, PX, PY, L == HUB12_SERPENTINE);
+  }
+  CHECK(!t->setGrayscale(Bits == 1 ? 2 : 1), "%s: setGrayscale() distinto de Bits", name);
+  setup(*t, m, Bits);
+  setup(*r, m, Bits);
+  CHECK(t->begin() && r->begin(), "%s: begin", name);   // mismo cableado: el panel virtual sirve a los dos
+  CHECK(t->width() == r->width() && t->height() == r->height(), "%s: tamaño", name);
+
+  TestRng rt(7), rr(7);
+  int diffs = 0;
+  for (int f = 0; f < 120 && diffs < 3; f++) {
+    randomDraw(*t, rt, 1 + f % 5);
+    randomDraw(*r, rr, 1 + f % 5);
+    t->update();
+    r->update();
+    bool same = true;
+    for (uint8_t row = 0; row < 4; row++) same = same && t->rowLit(row) == r->rowLit(row);
+    if (f % 8 == 7) {
+      same = same && onTimes(*t) == onTimes(*r);
+      CHECK(shownMismatches(*t) == 0, "%s f=%d: lo encendido no es lo dibujado", name, f);
+    }
+    if (!same) {
+      diffs++;
+      CHECK(same, "%s f=%d: distinto del HUB12_1DATA", name, f);
+    }
+  }
+  t->end();
+  CHECK(t->begin(), "%s: begin() después de end()", name);
+  delete t;
+  delete r;
+}
+
+template <uint8_t PX, uint8_t PY, HUB12Layout L, uint8_t Bits>
+static void allModes() {
+  for (int m = 0; m < MODES; m++) compare<PX, PY, L, Bits>((Mode)m);
+}
+
+int main() {
+  hostSetRealClock(false);
+  allModes<1, 1, HUB12_LINEAR, 1>();
+  allModes<4, 2, HUB12_SERPENTINE, 1>();
+  allModes<3, 2, HUB12_SERPENTINE, 2>();
+  allModes<2, 3, HUB12_LINEAR, 3>();
+  allModes<4, 1, HUB12_SERPENTINE, 4>();
+  allModes<2, 4, HUB12_SERPENTINE, 1>();
+  return testResult("fixed_geometry");
+}
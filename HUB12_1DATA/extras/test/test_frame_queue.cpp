@@ -0,0 +1,121 @@
+// Cola de frames con hora, con el reloj virtual (un ciclo de refresh() = 4 x
+// onTimeUs, vsync al empezar cada ciclo):
+//  - cada frame aparece en el primer vsync con micros() >= atUs y queda hasta
+//    el próximo vencido; update() con algo nuevo vuelve al vivo;
+//  - getQueueStats(): queued/shown, dropped (vencidos juntos: solo el último),
+//    underruns (encolados después de su vsync), full y maxLateUs;
+//  - queueFrame() no se come lo dibujado: el próximo update() lo publica, sin
+//    volver a armarlo.
+#include "test_util.h"
+
+static const uint16_t kOnUs = 250;
+static const uint32_t kCycleUs = 4u * kOnUs;
+
+// Frame i: una columna encendida en x = i
+static void drawFrame(HUB12_1DATA& d, int i) {
+  d.clear();
+  d.drawFastVLine(i, 0, d.height(), true);
+}
+
+// Un ciclo de refresco; devuelve la columna que se vio (-1: vacío, -2: otra cosa)
+static int cycle(HUB12_1DATA& d) {
+  HUB12Host.clearImage();
+  d.refresh();
+  int col = -1;
+  for (int x = 0; x < d.width(); x++) {
+    int n = 0;
+    for (int y = 0; y < d.height(); y++) n += HUB12Host.lit(x, y);
+    if (n == 0) continue;
+    if (n != d.height() || col != -1) return -2;
+    col = x;
+  }
+  return col;
+}
+
+static void testQueue(bool dbl) {
+  HUB12_1DATA d(kTestPins, 2, 1, false);
+  CHECK(d.setFrameQueue(4), "setFrameQueue");
+  d.setDoubleBuffer(dbl);
+  d.setOnTimeUs(kOnUs);
+  CHECK(d.begin(), "begin");
+  CHECK(!d.setFrameQueue(2), "setFrameQueue después de begin()");
+
+  // Tres frames a mitad de ciclo: cada uno en el vsync siguiente a su hora
+  uint32_t t0 = micros();
+  for (int i = 0; i < 3; i++) {
+    drawFrame(d, 10 + i);
+    CHECK(d.queueFrame(t0 + kCycleUs / 2 + i * kCycleUs), "dbl=%d: queueFrame %d", dbl, i);
+  }
+  CHECK(d.queuedFrames() == 3, "dbl=%d: %u en cola", dbl, d.queuedFrames());
+  CHECK(cycle(d) == -1, "dbl=%d: vsync 0 no muestra el vivo (vacío)", dbl);
+  for (int i = 0; i < 3; i++) {
+    int got = cycle(d);
+    CHECK(got == 10 + i, "dbl=%d: vsync %d muestra %d, no %d", dbl, i + 1, got, 10 + i);
+  }
+  CHECK(cycle(d) == 12, "dbl=%d: el último frame de la cola no quedó en pantalla", dbl);
+  HUB12QueueStats q = d.getQueueStats();
+  CHECK(q.queued == 3 && q.shown == 3 && q.dropped == 0 && q.underruns == 0 && q.full == 0,
+        "dbl=%d: queued %u shown %u dropped %u underruns %u full %u", dbl, q.queued, q.shown,
+        q.dropped, q.underruns, q.full);
+  CHECK(q.maxLateUs == kCycleUs / 2, "dbl=%d: maxLateUs %u", dbl, q.maxLateUs);
+
+  // update() con algo nuevo vuelve al vivo
+  drawFrame(d, 20);
+  d.update();
+  CHECK(cycle(d) == 20, "dbl=%d: update() no volvió al vivo", dbl);
+
+  // Dos vencidos en el mismo vsync: se muestra el último, el otro es dropped
+  d.resetQueueStats();
+  uint32_t now = micros();
+  drawFrame(d, 30);
+  d.queueFrame(now + 100);
+  drawFrame(d, 31);
+  d.queueFrame(now + 200);
+  CHECK(cycle(d) == 20, "dbl=%d: vencieron antes de su hora", dbl);   // vsync en now
+  CHECK(cycle(d) == 31, "dbl=%d: con dos vencidos no se mostró el último", dbl);
+  q = d.getQueueStats();
+  CHECK(q.shown == 1 && q.dropped == 1 && q.underruns == 0, "dbl=%d: shown %u dropped %u underruns %u",
+        dbl, q.shown, q.dropped, q.underruns);
+
+  // Encolado con una hora que ya pasó antes del vsync anterior: underrun
+  d.resetQueueStats();
+  drawFrame(d, 40);
+  d.queueFrame(micros() - 2 * kCycleUs);
+  CHECK(cycle(d) == 40, "dbl=%d: el atrasado no se mostró", dbl);
+  q = d.getQueueStats();
+  CHECK(q.shown == 1 && q.underruns == 1, "dbl=%d: shown %u underruns %u", dbl, q.shown, q.underruns);
+  CHECK(q.maxLateUs >= 2 * kCycleUs, "dbl=%d: maxLateUs %u", dbl, q.maxLateUs);
+
+  // Cola llena: el frame en pantalla sigue ocupando su lugar
+  d.resetQueueStats();
+  uint32_t far = micros() + 1000000;
+  int ok = 0;
+  for (int i = 0; i < 6; i++) ok += d.queueFrame(far + i);
+  q = d.getQueueStats();
+  CHECK(ok == 3 && q.full == 3 && q.queued == 3, "dbl=%d: aceptados %d full %u", dbl, ok, q.full);
+  d.clearFrameQueue();
+  CHECK(cycle(d) == 20, "dbl=%d: clearFrameQueue no volvió al vivo", dbl);
+  CHECK(d.queuedFrames() == 0, "dbl=%d: clearFrameQueue dejó %u", dbl, d.queuedFrames());
+
+  // queueFrame() no se queda con lo dibujado: update() lo publica en vivo
+  drawFrame(d, 50);
+  d.queueFrame(micros() + 1000000);
+  if (!dbl) {   // con doble buffer update() siempre intercambia y publica
+    d.setStatsEnabled(true);
+    d.resetStats();
+    d.update();
+    CHECK(d.framePending(), "dbl=%d: update() después de queueFrame() no publicó", dbl);
+    // el back ya estaba armado: se publica sin reconstruir ni re-codificar
+    CHECK(d.getStats().builds == 0, "dbl=%d: update() reconstruyó %u veces", dbl, d.getStats().builds);
+    d.setStatsEnabled(false);
+    CHECK(cycle(d) == 50, "dbl=%d: el vivo no muestra lo encolado", dbl);
+  }
+  d.clearFrameQueue();
+}
+
+int main() {
+  hostSetRealClock(false);
+  testQueue(false);
+  testQueue(true);
+  return testResult("frame_queue");
+}
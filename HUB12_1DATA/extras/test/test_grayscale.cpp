@@ -0,0 +1,74 @@
+// Escala de grises BCM medida en el panel virtual:
+//  - cada LED queda encendido nivel x unidad (unidad = onTimeUs / maxLevel),
+//    con refresh() y con refreshRow() + la espera que devuelve su peso;
+//  - cada fila se carga una vez por plano: 4 x bits filas por ciclo;
+//  - el ciclo dura 4 x onTimeUs en todas las profundidades (± redondeo de la unidad).
+// Con el reloj real apagado micros() solo avanza con delayMicroseconds(): los
+// tiempos son exactos, independientes de la máquina y de los sanitizers.
+#include "test_util.h"
+#include <vector>
+
+static const uint16_t kOnUs = 600;
+
+// Tiempo ON esperado de un nivel: la suma de las ranuras de sus planos
+static uint32_t expectedOnUs(uint8_t level, uint8_t bits) {
+  uint32_t mx = (1u << bits) - 1, us = 0;
+  for (uint8_t k = 0; k < bits; k++)
+    if (level & (1u << k)) us += bits == 1 ? kOnUs : ((uint32_t)kOnUs << k) / mx;
+  return us;
+}
+
+static void testOnTime(uint8_t chains, uint8_t bits, bool rowByRow) {
+  HUB12_1DATA* dp = chains > 1 ? new HUB12_1DATA(testPinsMulti(chains), 2, 1, false)
+                               : new HUB12_1DATA(kTestPins, 2, 1, false);
+  HUB12_1DATA& d = *dp;
+  if (bits > 1) CHECK(d.setGrayscale(bits), "setGrayscale(%d)", bits);
+  CHECK(d.begin(), "begin bits=%d", bits);
+  d.setOnTimeUs(kOnUs);
+
+  int W = d.width(), H = d.height();
+  std::vector<uint8_t> g(W * H);
+  for (int i = 0; i < W * H; i++) g[i] = (uint8_t)((i * 37) % 256);
+  d.drawGrayBitmap(0, 0, g.data(), W, H);
+  d.update();
+
+  HUB12Host.clearImage();
+  unsigned long t0 = micros();
+  if (!rowByRow) {
+    d.refresh();
+  } else {
+    for (int i = 0; i < 4 * bits; i++) {
+      uint8_t w = d.refreshRow();
+      delayMicroseconds((uint32_t)kOnUs * w / d.maxLevel());
+    }
+  }
+  unsigned long cycle = micros() - t0;
+  uint32_t rows = HUB12Host.rowsShown();
+  d.refreshRow();   // el próximo shift apaga OE: cierra la ranura de la última fila
+
+  int bad = 0;
+  for (int y = 0; y < H; y++)
+    for (int x = 0; x < W; x++) {
+      uint32_t exp = expectedOnUs(d.getPixelLevel(x, y), bits);
+      uint32_t got = HUB12Host.onTimeUs(x, y);
+      if (got != exp) {
+        if (bad++ < 3)
+          printf("  (%d,%d) nivel %d: %u us, esperado %u\n", x, y, d.getPixelLevel(x, y), got, exp);
+      }
+    }
+  CHECK(bad == 0, "chains=%d bits=%d rowByRow=%d: %d pixeles fuera de tiempo", chains, bits,
+        rowByRow, bad);
+  CHECK(rows == 4u * bits, "chains=%d bits=%d: %u filas por ciclo", chains, bits, rows);
+  uint32_t expCycle = 4u * expectedOnUs(d.maxLevel(), bits);
+  CHECK(cycle == expCycle && expCycle + 4u * bits >= 4u * kOnUs, "bits=%d: ciclo de %lu us", bits,
+        cycle);
+  delete dp;
+}
+
+int main() {
+  hostSetRealClock(false);
+  for (uint8_t chains = 1; chains <= 2; chains++)
+    for (uint8_t bits = 1; bits <= 4; bits++)
+      for (int rowByRow = 0; rowByRow < 2; rowByRow++) testOnTime(chains, bits, rowByRow);
+  return testResult("grayscale");
+}
@@ -0,0 +1,101 @@
+// Streams de salida decodificados con el panel virtual:
+//  - encodeSpiStream(): el stream SPI (lo que sacaría MOSI, MSB primero) se
+//    desplaza bit a bit en HUB12Host y la imagen resultante tiene que ser la del
+//    scan de origen.
+//  - bit-slice multi-cadena: refresh() con 1..8 cadenas DATA; cada cadena se
+//    decodifica en su propio registro y la imagen tiene que ser la dibujada.
+#include "test_util.h"
+
+static void pin(int p, bool high) { HUB12Host.gpioWrite(false, high, 1u << p); }
+
+// Lo que haría el SPI: cada bit del stream en DATA con un flanco de CLK; después
+// LAT, fila y un pulso de OE por fila.
+static void shiftSpiStream(const uint8_t* stream, uint32_t bytesPerR) {
+  const HUB12_1DATA::Pins& p = kTestPins;
+  for (uint8_t r = 0; r < 4; r++) {
+    pin(p.oe, false);
+    pin(p.a, r & 1);
+    pin(p.b, r & 2);
+    const uint8_t* row = stream + (uint32_t)r * bytesPerR;
+    for (uint32_t i = 0; i < bytesPerR; i++)
+      for (int b = 7; b >= 0; b--) {
+        pin(p.data, (row[i] >> b) & 1);
+        pin(p.clk, true);
+        pin(p.clk, false);
+      }
+    pin(p.lat, true);
+    pin(p.lat, false);
+    pin(p.oe, true);
+  }
+  pin(p.oe, false);
+}
+
+static void testSpiStream(uint8_t px, uint8_t py, bool serp) {
+  HUB12_1DATA d(kTestPins, px, py, serp);
+  CHECK(d.begin(), "begin %dx%d", px, py);
+  uint32_t bytesPerR = 16u * px * py;
+  uint8_t* scan = (uint8_t*)calloc(bytesPerR * 4, 1);
+  uint8_t* spi = (uint8_t*)calloc(bytesPerR * 4, 1);
+  TestRng rng(77 + px * 10 + py);
+
+  for (int f = 0; f < 40; f++) {
+    randomDraw(d, rng, 1 + rng.below(6));
+    referenceScan(d, px, serp, scan);
+    HUB12_1DATA::encodeSpiStream(scan, spi, bytesPerR * 4);
+
+    // byte a byte: el stream es el scan invertido (DATA activo LOW)
+    int inv = 0;
+    for (uint32_t i = 0; i < bytesPerR * 4; i++) if (spi[i] != (uint8_t)~scan[i]) inv++;
+    CHECK(inv == 0, "%dx%d f%d: %d bytes no invertidos", px, py, f, inv);
+
+    HUB12Host.clearImage();
+    shiftSpiStream(spi, bytesPerR);
+    int bad = 0;
+    for (int y = 0; y < d.height(); y++)
+      for (int x = 0; x < d.width(); x++)
+        if (HUB12Host.lit(x, y) != d.getPixel(x, y)) bad++;
+    CHECK(bad == 0, "SPI %dx%d serp=%d f%d: %d pixeles distintos", px, py, serp, f, bad);
+    CHECK(HUB12Host.latches() == 4, "latches=%u", HUB12Host.latches());
+  }
+  free(scan);
+  free(spi);
+}
+
+static void testSlices(uint8_t px, uint8_t py, bool serp, uint8_t chains, uint8_t bits) {
+  HUB12_1DATA d(testPinsMulti(chains), px, py, serp);
+  if (bits > 1) d.setGrayscale(bits);
+  CHECK(d.begin(), "begin %dx%d chains=%d", px, py, chains);
+  TestRng rng(1000 + chains * 7 + bits);
+
+  for (int f = 0; f < 40; f++) {
+    randomDraw(d, rng, 1 + rng.below(6));
+    d.update();
+    int bad = shownMismatches(d);
+    CHECK(bad == 0, "slices %dx%d chains=%d bits=%d f%d: %d pixeles distintos", px, py, chains, bits,
+          f, bad);
+  }
+  // shift por fila y plano: bytesPerR*8/chains flancos
+  HUB12Host.clearImage();
+  d.fillRect(0, 0, d.width(), d.height(), true);
+  d.update();
+  d.refresh();
+  uint32_t expect = 4u * bits * 128u * px * py / chains;
+  CHECK(HUB12Host.clocks() == expect, "chains=%d clocks=%u esperado %u", chains, HUB12Host.clocks(),
+        expect);
+}
+
+int main() {
+  testSpiStream(1, 1, false);
+  testSpiStream(3, 2, true);
+  testSpiStream(4, 1, false);
+  testSpiStream(2, 3, true);
+
+  testSlices(4, 2, true, 1, 1);
+  testSlices(4, 2, true, 2, 1);
+  testSlices(4, 2, false, 4, 1);
+  testSlices(4, 2, true, 8, 1);
+  testSlices(3, 2, true, 3, 1);
+  testSlices(3, 2, true, 2, 2);
+  testSlices(2, 2, false, 4, 3);
+  return testResult("output_stream");
+}
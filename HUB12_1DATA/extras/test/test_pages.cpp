@@ -0,0 +1,150 @@
+// Páginas pre-codificadas y lista de reproducción en el panel virtual:
+//  - showPage() muestra exactamente lo que había al hacer bakePage(), cruda o
+//    RLE, en monocromo, escala de grises y con varias cadenas;
+//  - tamaños: cruda = pageRawBytes(), RLE nunca mayor (lo que no comprime se
+//    guarda crudo);
+//  - bakePage() no se come lo dibujado: el próximo update() lo publica sin
+//    volver a armarlo;
+//  - freePage()/reuso, sin lugar (-1), end() libera;
+//  - playlistUpdate() cambia de página a la hora con el reloj virtual.
+#include "test_util.h"
+#include <fonts/SystemFont5x7.h>
+#include <vector>
+
+// Imagen del panel virtual después de un ciclo (nivel > 0 en grises)
+static std::vector<uint8_t> shown(HUB12_1DATA& d) {
+  HUB12Host.clearImage();
+  d.refresh();
+  std::vector<uint8_t> img(d.width() * d.height());
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) img[y * d.width() + x] = HUB12Host.lit(x, y);
+  return img;
+}
+
+static std::vector<uint8_t> drawn(HUB12_1DATA& d) {
+  std::vector<uint8_t> img(d.width() * d.height());
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) img[y * d.width() + x] = d.getPixelLevel(x, y) > 0;
+  return img;
+}
+
+static void drawTextPage(HUB12_1DATA& d, int n) {
+  char line[16];
+  d.clear();
+  for (int y = 0; y + 7 <= d.height(); y += 8) {
+    snprintf(line, sizeof(line), "P%d L%d 123", n, y / 8);
+    d.drawText(0, y, line);
+  }
+}
+
+static void testPages(HUB12_1DATA& d, const char* name) {
+  CHECK(d.begin(), "%s: begin", name);
+  d.setFont(SystemFont5x7);
+  CHECK(d.pageCount() == 0 && d.showPage(0) == false, "%s: páginas antes de bakePage()", name);
+
+  std::vector<std::vector<uint8_t> > want;
+  std::vector<int> ids;
+  TestRng rng(9);
+  for (int p = 0; p < 6; p++) {
+    if (p < 4) drawTextPage(d, p);
+    else randomDraw(d, rng, 30);   // ruido: puede no comprimir
+    bool rle = p & 1;
+    int id = d.bakePage(rle);
+    CHECK(id == p, "%s: bakePage %d devolvió %d", name, p, id);
+    ids.push_back(id);
+    want.push_back(drawn(d));
+    uint32_t bytes = d.pageBytes(id);
+    if (!rle) CHECK(bytes == d.pageRawBytes(), "%s: cruda %u B, no %u", name, bytes, d.pageRawBytes());
+    else CHECK(bytes > 0 && bytes <= d.pageRawBytes(), "%s: RLE %u B", name, bytes);
+    if (rle && p < 4)
+      CHECK(bytes < d.pageRawBytes(), "%s: texto en RLE %u B de %u", name, bytes, d.pageRawBytes());
+  }
+  CHECK(d.pageCount() == 6, "%s: pageCount %u", name, d.pageCount());
+
+  // bakePage() no publica, pero lo dibujado queda para el próximo update() (con
+  // doble buffer bakePage() ya intercambió, como update(): no aplica)
+  if (!d.isDoubleBuffer()) {
+    d.setStatsEnabled(true);
+    d.resetStats();
+    d.update();
+    CHECK(d.framePending(), "%s: update() después de bakePage() no publicó", name);
+    // publica el back que armó bakePage(), sin buildScan() (nativo cuenta la publicación)
+    uint32_t builds = d.getStats().builds;
+    CHECK(builds == (d.isPanelNative() ? 1u : 0u), "%s: update() con %u builds", name, builds);
+    d.setStatsEnabled(false);
+    CHECK(shown(d) == want.back(), "%s: el vivo no es lo dibujado", name);
+  }
+
+  for (int k = 0; k < 12; k++) {
+    int p = (k * 5) % 6;
+    CHECK(d.showPage(ids[p]), "%s: showPage %d", name, p);
+    CHECK(shown(d) == want[p], "%s: la página %d no se ve igual", name, p);
+  }
+
+  // invalidate() + update() vuelve a lo dibujado (con doble buffer update()
+  // intercambia y muestra el otro buffer)
+  if (!d.isDoubleBuffer()) {
+    d.invalidate();
+    d.update();
+    CHECK(shown(d) == want.back(), "%s: invalidate() no volvió a lo dibujado", name);
+  }
+
+  d.freePage(ids[2]);
+  CHECK(d.pageCount() == 5 && !d.showPage(ids[2]) && d.pageBytes(ids[2]) == 0, "%s: freePage", name);
+  CHECK(d.bakePage() == ids[2], "%s: no reusó la página libre", name);
+  while (d.bakePage() >= 0) {}
+  CHECK(d.pageCount() == HUB12_MAX_PAGES, "%s: %u páginas al llenar", name, d.pageCount());
+  d.end();
+  CHECK(d.pageCount() == 0, "%s: end() no liberó las páginas", name);
+}
+
+static void testPlaylist() {
+  HUB12_1DATA d(kTestPins, 2, 1, false);
+  CHECK(d.begin(), "begin");
+  d.setFont(SystemFont5x7);
+  int p[3];
+  std::vector<uint8_t> want[3];
+  for (int i = 0; i < 3; i++) {
+    drawTextPage(d, i);
+    p[i] = d.bakePage(true);
+    want[i] = drawn(d);
+  }
+  CHECK(!d.playlistUpdate() && d.playlistCurrent() == -1, "playlist vacía");
+  CHECK(d.playlistAdd(p[0], 100) && d.playlistAdd(p[1], 250) && d.playlistAdd(p[2], 50), "playlistAdd");
+
+  // cambios en t = 0, 100, 350, 400, 500, 750, 800, 900
+  std::vector<int> seq;
+  for (int ms = 0; ms < 1000; ms += 10) {
+    if (d.playlistUpdate()) {
+      seq.push_back(d.playlistCurrent());
+      CHECK(shown(d) == want[d.playlistCurrent()], "t=%d: la entrada %d no se ve", ms, d.playlistCurrent());
+    }
+    delay(10);
+  }
+  static const int kSeq[] = { 0, 1, 2, 0, 1, 2, 0, 1 };
+  bool ok = seq.size() == 8;
+  for (size_t i = 0; ok && i < seq.size(); i++) ok = seq[i] == kSeq[i];
+  CHECK(ok, "secuencia de la lista (%zu cambios)", seq.size());
+  d.playlistClear();
+  CHECK(!d.playlistUpdate() && d.playlistCurrent() == -1, "playlistClear");
+}
+
+int main() {
+  hostSetRealClock(false);
+  {
+    HUB12_1DATA d(kTestPins, 4, 2, true);
+    testPages(d, "1 cadena");
+  }
+  {
+    HUB12_1DATA d(testPinsMulti(2), 4, 2, false);
+    d.setGrayscale(2);
+    testPages(d, "2 cadenas + grises");
+  }
+  {
+    HUB12_1DATA d(kTestPins, 2, 2, false);
+    d.setDoubleBuffer(true);
+    testPages(d, "doble buffer");
+  }
+  testPlaylist();
+  return testResult("pages");
+}
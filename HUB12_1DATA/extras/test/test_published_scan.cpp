@@ -0,0 +1,81 @@
+// publishedScan() byte a byte contra el builder de 1.0.0 (referenceScan()):
+// después de cada update() el scan publicado tiene que ser exactamente el que
+// armaba 1.0.0 desde los pixeles, no solo dar la misma imagen en el panel
+// virtual. Geometrías lineales y serpentina, updates parciales (pocas primitivas
+// por frame), escala de grises (un juego por plano), salida SPI, modo nativo y
+// la variante HUB12<> de geometría fija.
+#include "test_util.h"
+#include <HUB12.h>
+
+enum Mode { PLAIN, SPI, NATIVE, MODES };
+static const char* kModeName[MODES] = { "simple", "SPI", "nativo" };
+
+// Bytes distintos entre el scan publicado y la referencia, en todos los planos
+static int scanMismatches(const HUB12_1DATA& d, uint8_t panelsX, bool serp, uint8_t* ref) {
+  int bad = 0;
+  for (uint8_t k = 0; k < d.grayscaleBits(); k++) {
+    referenceScan(d, panelsX, serp, ref, k);
+    const uint8_t* scan = d.publishedScan() + (uint32_t)k * d.scanBytes();
+    if (memcmp(scan, ref, d.scanBytes()) == 0) continue;
+    for (uint32_t i = 0; i < d.scanBytes(); i++) if (scan[i] != ref[i]) bad++;
+  }
+  return bad;
+}
+
+static void run(HUB12_1DATA& d, uint8_t px, uint8_t py, bool serp, const char* what, uint32_t seed) {
+  CHECK(d.begin(), "begin %s %dx%d", what, px, py);
+  CHECK(d.scanBytes() == 64u * px * py, "%s %dx%d: scanBytes=%u", what, px, py, d.scanBytes());
+  uint8_t* ref = (uint8_t*)malloc(d.scanBytes());
+  TestRng rng(seed);
+
+  d.update();
+  int bad = scanMismatches(d, px, serp, ref);
+  CHECK(bad == 0, "%s %dx%d serp=%d vacío: %d bytes distintos", what, px, py, serp, bad);
+
+  for (int f = 0; f < 60; f++) {
+    randomDraw(d, rng, 1 + rng.below(f < 30 ? 2 : 8));
+    d.update();
+    bad = scanMismatches(d, px, serp, ref);
+    CHECK(bad == 0, "%s %dx%d serp=%d f%d: %d bytes distintos", what, px, py, serp, f, bad);
+  }
+  // update() sin cambios no toca el scan publicado
+  d.update();
+  bad = scanMismatches(d, px, serp, ref);
+  CHECK(bad == 0, "%s %dx%d serp=%d sin cambios: %d bytes distintos", what, px, py, serp, bad);
+  free(ref);
+}
+
+static void testDynamic(uint8_t px, uint8_t py, bool serp, Mode m, uint8_t bits) {
+  HUB12_1DATA d(kTestPins, px, py, serp);
+  if (bits > 1) d.setGrayscale(bits);
+  if (m == SPI) d.setSpiOutput(true);
+  if (m == NATIVE) d.setPanelNative(true);
+  char what[32];
+  snprintf(what, sizeof(what), "%s %d bits", kModeName[m], bits);
+  run(d, px, py, serp, what, 500u + px * 31u + py * 7u + serp + m * 3u + bits);
+}
+
+template <uint8_t PX, uint8_t PY, HUB12Layout L, uint8_t Bits>
+static void testFixed() {
+  HUB12<PX, PY, L, Bits> d(kTestPins);
+  run(d, PX, PY, L == HUB12_SERPENTINE, "HUB12<>", 900u + PX * 13u + PY + Bits);
+}
+
+int main() {
+  static const uint8_t geo[][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 }, { 3, 2 }, { 4, 2 }, { 6, 3 } };
+  for (const auto& g : geo)
+    for (int serp = 0; serp < 2; serp++) {
+      testDynamic(g[0], g[1], serp, PLAIN, 1);
+      testDynamic(g[0], g[1], serp, SPI, 1);
+      testDynamic(g[0], g[1], serp, NATIVE, 1);
+    }
+  testDynamic(3, 2, true, PLAIN, 2);
+  testDynamic(2, 2, false, PLAIN, 3);
+  testDynamic(4, 2, true, SPI, 4);
+
+  testFixed<1, 1, HUB12_LINEAR, 1>();
+  testFixed<3, 2, HUB12_SERPENTINE, 1>();
+  testFixed<4, 2, HUB12_LINEAR, 2>();
+  testFixed<6, 3, HUB12_SERPENTINE, 3>();
+  return testResult("published_scan");
+}
@@ -0,0 +1,100 @@
+// Triple buffer con dos hilos: un productor dibuja el frame f y llama update();
+// un consumidor llama refresh() (o 4 x planos refreshRow()) sobre el panel
+// virtual. Cada ciclo de 4 filas tiene que mostrar un único frame entero:
+//  - la fila 0 de la pantalla lleva f en sus primeros 32 pixeles;
+//  - el resto de la imagen es pattern(f) y se compara completa;
+//  - f nunca retrocede entre ciclos.
+// Correr también con `make tsan`.
+#include "test_util.h"
+#include <atomic>
+#include <thread>
+
+static uint32_t mix(uint32_t f) {
+  f ^= f >> 16; f *= 0x7feb352du;
+  f ^= f >> 15; f *= 0x846ca68bu;
+  return f ^ (f >> 16);
+}
+
+static bool pattern(uint32_t f, int x, int y) {
+  if (y == 0 && x < 32) return (f >> x) & 1;
+  return (mix(f) >> ((x * 5 + y * 3) & 31)) & 1;
+}
+
+static void drawFrame(HUB12_1DATA& d, uint32_t f) {
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++) d.drawPixel(x, y, pattern(f, x, y));
+}
+
+static void stress(HUB12_1DATA& d, const char* name, bool rowByRow, uint32_t frames) {
+  CHECK(d.begin(), "%s: begin", name);
+  int planes = 0;
+  while ((1 << planes) <= d.maxLevel()) planes++;
+  drawFrame(d, 0);
+  d.update();
+
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (uint32_t f = 1; f <= frames; f++) {
+      drawFrame(d, f);
+      d.update();
+    }
+    done = true;
+  });
+
+  int W = d.width(), H = d.height();
+  uint32_t last = 0, cycles = 0, seen = 0;
+  int bad = 0;
+  bool finalCycle = false;
+  while (!finalCycle) {
+    finalCycle = done;   // un ciclo más después del último update()
+    HUB12Host.clearImage();
+    if (rowByRow)
+      for (int i = 0; i < 4 * planes; i++) d.refreshRow();
+    else
+      d.refresh();
+    cycles++;
+
+    uint32_t f = 0;
+    for (int x = 0; x < 32; x++)
+      if (HUB12Host.lit(x, 0)) f |= 1u << x;
+    int mism = 0;
+    for (int y = 0; y < H; y++)
+      for (int x = 0; x < W; x++)
+        if (HUB12Host.lit(x, y) != pattern(f, x, y)) mism++;
+    if (mism && bad++ < 3) printf("  %s: ciclo %u frame %u con %d pixeles de otro\n", name, cycles, f, mism);
+    CHECK(f >= last, "%s: el frame retrocede %u -> %u", name, last, f);
+    if (f != last) seen++;
+    last = f;
+  }
+  producer.join();
+
+  CHECK(bad == 0, "%s: %d ciclos mezclan frames (de %u)", name, bad, cycles);
+  CHECK(last == frames, "%s: el último ciclo muestra %u, no %u", name, last, frames);
+  CHECK(seen > 1, "%s: solo %u frames distintos en %u ciclos", name, seen, cycles);
+  printf("  %s: %u ciclos, %u frames distintos\n", name, cycles, seen);
+}
+
+int main() {
+  hostSetRealClock(false);
+  for (int rowByRow = 0; rowByRow < 2; rowByRow++) {
+    {
+      HUB12_1DATA d(kTestPins, 2, 2, true);
+      d.setOnTimeUs(0);
+      stress(d, rowByRow ? "1 cadena refreshRow" : "1 cadena", rowByRow, 3000);
+    }
+    {
+      HUB12_1DATA d(testPinsMulti(2), 2, 2, false);
+      d.setDoubleBuffer(true);
+      d.setOnTimeUs(0);
+      stress(d, rowByRow ? "2 cadenas + doble buffer refreshRow" : "2 cadenas + doble buffer",
+             rowByRow, 3000);
+    }
+    {
+      HUB12_1DATA d(kTestPins, 2, 1, false);
+      d.setGrayscale(2);
+      d.setOnTimeUs(0);
+      stress(d, rowByRow ? "grises refreshRow" : "grises", rowByRow, 3000);
+    }
+  }
+  return testResult("triple_buffer");
+}
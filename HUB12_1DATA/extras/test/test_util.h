@@ -0,0 +1,87 @@
+#pragma once
+// Helpers mínimos de los tests de PC: CHECK() cuenta y muestra fallos sin cortar
+// el test, testResult() imprime el resumen y da el código de salida.
+#include <HUB12_1DATA.h>
+
+static long g_fails = 0;
+
+#define CHECK(cond, ...)                                              \
+  do {                                                                \
+    if (!(cond)) {                                                    \
+      if (g_fails++ < 20) {                                           \
+        printf("FALLO %s:%d: (%s) ", __FILE__, __LINE__, #cond);      \
+        printf(__VA_ARGS__);                                          \
+        printf("\n");                                                 \
+      }                                                               \
+    }                                                                 \
+  } while (0)
+
+static inline int testResult(const char* name) {
+  printf("%s: %s (%ld fallos)\n", name, g_fails ? "FALLO" : "OK", g_fails);
+  return g_fails ? 1 : 0;
+}
+
+// Pines de prueba (todos < 32, un solo banco): OE, A, B, CLK, LAT, DATA
+static const HUB12_1DATA::Pins kTestPins = { 5, 6, 7, 8, 9, 10 };
+
+static inline HUB12_1DATA::PinsMulti testPinsMulti(uint8_t chains) {
+  HUB12_1DATA::PinsMulti p = { 5, 6, 7, 8, 9, chains, {} };
+  for (uint8_t c = 0; c < HUB12_MAX_CHAINS; c++) p.data[c] = 10 + c;
+  return p;
+}
+
+// LCG determinista: los tests dan siempre lo mismo
+struct TestRng {
+  uint32_t s;
+  explicit TestRng(uint32_t seed) : s(seed) {}
+  uint32_t next() { s = s * 1103515245u + 12345u; return s >> 8; }
+  int below(int n) { return (int)(next() % (uint32_t)n); }
+};
+
+// Unas cuantas primitivas al azar (incluye bordes fuera de pantalla)
+static inline void randomDraw(HUB12_1DATA& d, TestRng& rng, int ops) {
+  int W = d.width(), H = d.height();
+  for (int i = 0; i < ops; i++) {
+    d.setDrawLevel((uint8_t)(1 + rng.below(d.maxLevel())));
+    bool on = rng.below(3) != 0;
+    int x = rng.below(W + 8) - 4, y = rng.below(H + 8) - 4;
+    switch (rng.below(5)) {
+      case 0: d.fillRect(x, y, 1 + rng.below(24), 1 + rng.below(10), on); break;
+      case 1: d.drawPixel(x, y, on); break;
+      case 2: d.drawLine(x, y, rng.below(W), rng.below(H), on); break;
+      case 3: d.drawFastHLine(x, y, rng.below(W), on); break;
+      default: if (rng.below(6) == 0) d.clear(); else d.drawRect(x, y, 8, 6, on); break;
+    }
+  }
+  d.setDrawLevel(d.maxLevel());
+}
+
+// Scan de referencia desde los pixeles (formato de 1.0.0: fila r, panel en orden
+// de cadena, 16 bytes MSB primero). plane = bit del nivel (0 en monocromo).
+static inline void referenceScan(const HUB12_1DATA& d, uint8_t panelsX, bool serp, uint8_t* out,
+                                 uint8_t plane = 0) {
+  uint32_t bytesPerR = 16u * (d.width() / 32) * (d.height() / 16);
+  memset(out, 0, bytesPerR * 4);
+  for (int gy = 0; gy < d.height(); gy++)
+    for (int gx = 0; gx < d.width(); gx++) {
+      if (!((d.getPixelLevel(gx, gy) >> plane) & 1)) continue;
+      int px = gx / 32, py = gy / 16, lx = gx % 32, ly = gy % 16;
+      if (serp && (py & 1)) { px = panelsX - 1 - px; lx = 31 - lx; }
+      int sub = 3 - (ly >> 2);
+      int bit = (lx >> 3) * 32 + sub * 8 + (lx & 7);
+      out[(uint32_t)(ly & 3) * bytesPerR + (uint32_t)(py * panelsX + px) * 16 + (bit >> 3)] |=
+          (uint8_t)(1 << (7 - (bit & 7)));
+    }
+}
+
+// Un ciclo de refresh() sobre el panel virtual: ¿lo que encendió es lo dibujado?
+// (en escala de grises basta con nivel > 0). Devuelve los pixeles distintos.
+static inline int shownMismatches(HUB12_1DATA& d) {
+  HUB12Host.clearImage();
+  d.refresh();
+  int bad = 0;
+  for (int y = 0; y < d.height(); y++)
+    for (int x = 0; x < d.width(); x++)
+      if (HUB12Host.lit(x, y) != (d.getPixelLevel(x, y) > 0)) bad++;
+  return bad;
+}
@@ -0,0 +1,122 @@
+// present() / vsync en el panel virtual:
+//  - contadores: frameCount() sube uno por ciclo de 4 filas (refresh() o
+//    4 x planos refreshRow()), shownFrame() es la publicación que tomó el ciclo,
+//    framePending() entre update() y el vsync que lo toma;
+//  - present(0) con un frame pendiente no publica; onVSync() recibe frameCount();
+//  - dos hilos: el productor anima con present() y el refresco corre en otro
+//    hilo. Cada publicación llega a los LEDs (shownFrame avanza de a uno, sin
+//    saltos) y waitForVSync() vuelve por vsync o por timeout.
+#include "test_util.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+struct VSyncLog {
+  HUB12_1DATA* d;
+  std::vector<uint32_t> counts;   // n recibido
+  std::vector<uint32_t> shown;    // shownFrame() en ese vsync
+};
+
+static void onVs(uint32_t n, void* arg) {
+  VSyncLog* log = (VSyncLog*)arg;
+  log->counts.push_back(n);
+  log->shown.push_back(log->d->shownFrame());
+}
+
+static void testCounters(uint8_t bits) {
+  HUB12_1DATA d(kTestPins, 2, 1, false);
+  if (bits > 1) d.setGrayscale(bits);
+  CHECK(d.begin(), "begin");
+  VSyncLog log = { &d, {}, {} };
+  d.onVSync(onVs, &log);
+
+  CHECK(d.frameCount() == 0 && d.shownFrame() == 0, "bits=%d: contadores al empezar %u/%u", bits,
+        d.frameCount(), d.shownFrame());
+  uint32_t pub = 1;   // begin() publica la pantalla vacía
+  CHECK(d.framePending(), "bits=%d: begin() sin frame pendiente", bits);
+  for (int i = 0; i < 20; i++) {
+    d.fillRect(i, 0, 3, 16, true);
+    d.update();
+    pub++;
+    CHECK(d.framePending(), "bits=%d i=%d: update() sin frame pendiente", bits, i);
+
+    // present() sin espera: el frame anterior no se tomó, no arma otro
+    d.drawPixel(40, i % 16, true);
+    CHECK(!d.present(0), "bits=%d i=%d: present(0) publicó con un frame pendiente", bits, i);
+
+    uint32_t fc = d.frameCount();
+    if (i & 1) {
+      d.refresh();
+    } else {
+      for (int k = 0; k < 4 * bits; k++) d.refreshRow();
+    }
+    CHECK(d.frameCount() == fc + 1, "bits=%d i=%d: frameCount %u -> %u", bits, i, fc, d.frameCount());
+    CHECK(d.shownFrame() == pub, "bits=%d i=%d: shownFrame %u, esperado %u", bits, i, d.shownFrame(), pub);
+    CHECK(!d.framePending(), "bits=%d i=%d: el vsync no tomó el frame", bits, i);
+
+    CHECK(d.present(0), "bits=%d i=%d: present(0) sin frame pendiente", bits, i);
+    pub++;
+    d.refresh();
+    CHECK(d.shownFrame() == pub, "bits=%d i=%d: present() no llegó a los LEDs", bits, i);
+  }
+
+  // un vsync sin nada nuevo sigue mostrando la última publicación
+  d.refresh();
+  CHECK(d.shownFrame() == pub, "bits=%d: sin publicación cambió shownFrame", bits);
+
+  bool seq = log.counts.size() == d.frameCount();
+  for (size_t i = 0; i < log.counts.size(); i++) seq = seq && log.counts[i] == i + 1;
+  CHECK(seq, "bits=%d: onVSync recibió %zu llamadas para %u vsync", bits, log.counts.size(),
+        d.frameCount());
+}
+
+static void testThreads() {
+  HUB12_1DATA d(kTestPins, 2, 2, true);
+  d.setOnTimeUs(50);
+  CHECK(d.begin(), "begin");
+  VSyncLog log = { &d, {}, {} };
+  d.onVSync(onVs, &log);
+
+  std::atomic<bool> stop(false);
+  std::thread refresher([&] {
+    while (!stop) d.refresh();
+  });
+
+  const uint32_t kFrames = 500;
+  uint32_t base = 1, late = 0;   // begin() publicó la 1
+  for (uint32_t f = 0; f < kFrames; f++) {
+    d.fillRect(0, 0, d.width(), d.height(), false);
+    d.drawFastVLine(f % d.width(), 0, d.height(), true);
+    if (!d.present(200)) late++;
+  }
+  CHECK(late == 0, "%u present() vencidos", late);
+  CHECK(d.waitForVSync(200), "waitForVSync() con el refresco andando");
+  CHECK(d.waitForVSync(200), "waitForVSync() con el refresco andando");
+  stop = true;
+  refresher.join();
+
+  unsigned long t0 = millis();
+  CHECK(!d.waitForVSync(5), "waitForVSync() sin refresco no venció");
+  CHECK(millis() - t0 >= 5, "waitForVSync(5) volvió antes de tiempo");
+
+  // Cada publicación se mostró: shownFrame avanza de a uno por vsync, hasta la última
+  int skips = 0, back = 0;
+  for (size_t i = 1; i < log.shown.size(); i++) {
+    if (log.shown[i] > log.shown[i - 1] + 1) skips++;
+    if (log.shown[i] < log.shown[i - 1]) back++;
+  }
+  CHECK(skips == 0, "%d vsync saltaron publicaciones", skips);
+  CHECK(back == 0, "%d vsync retrocedieron", back);
+  CHECK(!log.shown.empty() && log.shown.back() == base + kFrames,
+        "última publicación mostrada %u, esperada %u", log.shown.empty() ? 0 : log.shown.back(),
+        base + kFrames);
+  printf("  hilos: %u frames con present(), %zu vsync\n", kFrames, log.shown.size());
+}
+
+int main() {
+  hostSetRealClock(false);
+  for (uint8_t bits = 1; bits <= 3; bits++) testCounters(bits);
+  hostSetRealClock(true);   // waitForVSync() sin refresco vence por millis()
+  testThreads();
+  return testResult("vsync");
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "HUB12_1DATA.h"
+
+// ---------- Variante con geometría fija ----------
+// HUB12<PanelsX, PanelsY, Layout, Bits>: misma API que HUB12_1DATA, pero con la
+// geometría en compilación:
+//  - framebuffer, 3 scans del triple buffer, dirty rows, conteos del limitador y
+//    mapa de paneles son arrays miembro (sin calloc en begin()).
+//  - el paso framebuffer -> scan de update() se genera panel por panel con
+//    offsets, espejo y tabla de cada panel como constantes.
+// Quedan en heap solo los opcionales: doble buffer, cola de frames, SPI/DMA,
+// multi-cadena y páginas. Para geometría elegida en runtime: HUB12_1DATA.
+//
+//   HUB12<2, 2, HUB12_SERPENTINE> display(pins);
+//
+template <uint8_t PanelsX, uint8_t PanelsY, HUB12Layout Layout = HUB12_LINEAR, uint8_t Bits = 1>
+class HUB12 : public HUB12_1DATA {
+  static_assert(PanelsX >= 1 && PanelsY >= 1, "HUB12<>: al menos 1 panel");
+  static_assert(Bits >= 1 && Bits <= 4, "HUB12<>: Bits entre 1 y 4");
+
+public:
+  static constexpr uint16_t kPanels   = (uint16_t)PanelsX * PanelsY;
+  static constexpr uint32_t kRowBytes = (uint32_t)PanelsX * 4;         // 32 px por panel
+  static constexpr uint32_t kFbBytes  = kRowBytes * 16 * PanelsY;
+  static constexpr uint32_t kBytesPerR = 16 * (uint32_t)kPanels;
+  static constexpr uint32_t kScanBytes = 4 * kBytesPerR;
+
+  explicit HUB12(const Pins& pins)
+  : HUB12_1DATA(pins, PanelsX, PanelsY, Layout == HUB12_SERPENTINE) { attachStorage(); }
+
+  explicit HUB12(const PinsMulti& pins)
+  : HUB12_1DATA(pins, PanelsX, PanelsY, Layout == HUB12_SERPENTINE) { attachStorage(); }
+
+  // Los buffers son de este objeto: se sueltan antes de que dejen de existir
+  ~HUB12() { end(); }
+
+private:
+  // Mapa de paneles en compilación (misma regla que initScanTables)
+  static constexpr bool mirrorOf(uint16_t i) {
+    return Layout == HUB12_SERPENTINE && ((i / PanelsX) & 1);
+  }
+  static constexpr uint16_t fbPanelOf(uint16_t i) {
+    return (uint16_t)((i / PanelsX) * PanelsX + (mirrorOf(i) ? PanelsX - 1 - i % PanelsX : i % PanelsX));
+  }
+  static constexpr uint32_t fbOfsOf(uint16_t i) {
+    return (i / PanelsX) * 16 * kRowBytes + (uint32_t)(fbPanelOf(i) % PanelsX) * 4;
+  }
+
+  // Un panel de la cadena (I), con todos sus offsets constantes
+  template <uint16_t I>
+  struct Panel {
+    static constexpr bool M = mirrorOf(I);
+    static constexpr uint16_t P = fbPanelOf(I);
+    static constexpr uint32_t O = fbOfsOf(I);
+
+    // Grupo g de 8 px de la fila ly (panel invertido: 3-g, sin invertir bits)
+    static inline uint8_t px8(const uint8_t* pb, const uint8_t* rev8, uint8_t ly, uint8_t g) {
+      uint8_t v = pb[(uint32_t)ly * kRowBytes + (M ? 3 - g : g)];
+      return M ? v : rev8[v];
+    }
+
+    static inline void build(HUB12_1DATA& d, uint8_t buf, const uint8_t* src,
+                             const uint16_t* stale, const uint8_t* rev8) {
+      uint16_t rows = d._dirtyRows[P] | stale[P];
+      if (!rows) return;
+
+      for (uint8_t k = 0; k < Bits; k++) {
+        const uint8_t* pb = src + k * kFbBytes + O;
+        uint8_t* po = d._scan[buf] + k * kScanBytes + (uint32_t)I * 16;
+
+        for (uint8_t r = 0; r < 4; r++) {
+          uint8_t* dst = po + r * kBytesPerR;
+          for (uint8_t sub = 0; sub < 4; sub++) {
+            uint8_t ly = (3 - sub) * 4 + r;
+            if (!(rows & (1u << ly))) continue;
+            dst[sub]      = px8(pb, rev8, ly, 0);
+            dst[sub + 4]  = px8(pb, rev8, ly, 1);
+            dst[sub + 8]  = px8(pb, rev8, ly, 2);
+            dst[sub + 12] = px8(pb, rev8, ly, 3);
+          }
+          if (rows & (0x1111u << r)) d.countBlock(buf, k, r, I, dst);
+        }
+      }
+    }
+  };
+
+  // Recorrido de la cadena desenrollado en compilación
+  template <uint16_t I, bool Last = (I + 1 >= kPanels)>
+  struct Chain {
+    static inline void build(HUB12_1DATA& d, uint8_t buf, const uint8_t* src,
+                             const uint16_t* stale, const uint8_t* rev8) {
+      Panel<I>::build(d, buf, src, stale, rev8);
+      Chain<I + 1>::build(d, buf, src, stale, rev8);
+    }
+  };
+  template <uint16_t I>
+  struct Chain<I, true> {
+    static inline void build(HUB12_1DATA& d, uint8_t buf, const uint8_t* src,
+                             const uint16_t* stale, const uint8_t* rev8) {
+      Panel<I>::build(d, buf, src, stale, rev8);
+    }
+  };
+
+  static void buildRowsT(HUB12_1DATA& d, uint8_t buf, const uint8_t* src) {
+    Chain<0>::build(d, buf, src, d._dirtyStale + (uint32_t)buf * kPanels, rev8Table());
+  }
+
+  void attachStorage() {
+    if (Bits > 1) setGrayscale(Bits);
+    _st.fb = _sfb;
+    for (uint8_t i = 0; i < 3; i++) _st.scan[i] = _sscan[i];
+    _st.dirtyRows = _sdirty;
+    _st.litCnt = _slit;
+    _st.panelMap = _smap;
+    _st.planes = Bits;
+    _storage = &_st;
+    _buildRowsFn = &buildRowsT;
+  }
+
+  HUB12Storage _st;
+  alignas(4) uint8_t _sfb[kFbBytes * Bits];
+  alignas(4) uint8_t _sscan[3][kScanBytes * Bits];   // popcount16 lee de a 32 bits
+  uint16_t _sdirty[kPanels * 4];                      // dirty + stale de los 3 scans
+  uint8_t _slit[kPanels * 4 * Bits * 3];
+  HUB12PanelMap _smap[kPanels];
+};
@@ -3,14 +3,39 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <new>
 #if defined(ESP32)
   #include "esp_timer.h"
+  #include "esp_heap_caps.h"
 #endif
 
+// ---------- Backend de pines ----------
+// gpioSet/gpioClr: poner en HIGH/LOW todos los pines de 'mask' en un banco (0..31 / 32..63).
+#if defined(ARDUINO)
 // Acceso directo a registros GPIO (ESP32 / ESP32-S3)
 #include "soc/gpio_struct.h"
 #include "soc/gpio_reg.h"
 
+static inline void gpioSet(bool hiBank, uint32_t mask) {
+  if (!hiBank) GPIO.out_w1ts = mask;
+  else         GPIO.out1_w1ts.val = mask;
+}
+
+static inline void gpioClr(bool hiBank, uint32_t mask) {
+  if (!hiBank) GPIO.out_w1tc = mask;
+  else         GPIO.out1_w1tc.val = mask;
+}
+#else
+// PC: las escrituras van al panel virtual HUB12Host (HUB12_host.cpp)
+static inline void gpioSet(bool hiBank, uint32_t mask) { hub12HostGpioWrite(hiBank, true, mask); }
+static inline void gpioClr(bool hiBank, uint32_t mask) { hub12HostGpioWrite(hiBank, false, mask); }
+#endif
+
+#if defined(ESP32)
+// Ciclos de CPU para medir la sección crítica (unos pocos ciclos, micros() no alcanza)
+static inline uint32_t statCycles() { return (uint32_t)ESP.getCycleCount(); }
+#endif
+
 // ---------- Fast GPIO helpers ----------
 static inline HUB12FastPin makeFastPin(int pin) {
   HUB12FastPin fp;
@@ -19,15 +44,29 @@ static inline HUB12FastPin makeFastPin(int pin) {
   return fp;
 }
 
-static inline void fastHigh(const HUB12FastPin& p) {
-  if (!p.hiBank) GPIO.out_w1ts = p.mask;
-  else           GPIO.out1_w1ts.val = p.mask;
-}
-
-static inline void fastLow(const HUB12FastPin& p) {
-  if (!p.hiBank) GPIO.out_w1tc = p.mask;
-  else           GPIO.out1_w1tc.val = p.mask;
-}
+static inline void fastHigh(const HUB12FastPin& p) { gpioSet(p.hiBank, p.mask); }
+static inline void fastLow(const HUB12FastPin& p)  { gpioClr(p.hiBank, p.mask); }
+
+// ---------- Tabla de inversión de bits ----------
+// El framebuffer guarda 8 px por byte LSB-first y el scan los espera MSB-first.
+static const uint8_t kRev8[256] = {
+  0x00,0x80,0x40,0xC0,0x20,0xA0,0x60,0xE0,0x10,0x90,0x50,0xD0,0x30,0xB0,0x70,0xF0,
+  0x08,0x88,0x48,0xC8,0x28,0xA8,0x68,0xE8,0x18,0x98,0x58,0xD8,0x38,0xB8,0x78,0xF8,
+  0x04,0x84,0x44,0xC4,0x24,0xA4,0x64,0xE4,0x14,0x94,0x54,0xD4,0x34,0xB4,0x74,0xF4,
+  0x0C,0x8C,0x4C,0xCC,0x2C,0xAC,0x6C,0xEC,0x1C,0x9C,0x5C,0xDC,0x3C,0xBC,0x7C,0xFC,
+  0x02,0x82,0x42,0xC2,0x22,0xA2,0x62,0xE2,0x12,0x92,0x52,0xD2,0x32,0xB2,0x72,0xF2,
+  0x0A,0x8A,0x4A,0xCA,0x2A,0xAA,0x6A,0xEA,0x1A,0x9A,0x5A,0xDA,0x3A,0xBA,0x7A,0xFA,
+  0x06,0x86,0x46,0xC6,0x26,0xA6,0x66,0xE6,0x16,0x96,0x56,0xD6,0x36,0xB6,0x76,0xF6,
+  0x0E,0x8E,0x4E,0xCE,0x2E,0xAE,0x6E,0xEE,0x1E,0x9E,0x5E,0xDE,0x3E,0xBE,0x7E,0xFE,
+  0x01,0x81,0x41,0xC1,0x21,0xA1,0x61,0xE1,0x11,0x91,0x51,0xD1,0x31,0xB1,0x71,0xF1,
+  0x09,0x89,0x49,0xC9,0x29,0xA9,0x69,0xE9,0x19,0x99,0x59,0xD9,0x39,0xB9,0x79,0xF9,
+  0x05,0x85,0x45,0xC5,0x25,0xA5,0x65,0xE5,0x15,0x95,0x55,0xD5,0x35,0xB5,0x75,0xF5,
+  0x0D,0x8D,0x4D,0xCD,0x2D,0xAD,0x6D,0xED,0x1D,0x9D,0x5D,0xDD,0x3D,0xBD,0x7D,0xFD,
+  0x03,0x83,0x43,0xC3,0x23,0xA3,0x63,0xE3,0x13,0x93,0x53,0xD3,0x33,0xB3,0x73,0xF3,
+  0x0B,0x8B,0x4B,0xCB,0x2B,0xAB,0x6B,0xEB,0x1B,0x9B,0x5B,0xDB,0x3B,0xBB,0x7B,0xFB,
+  0x07,0x87,0x47,0xC7,0x27,0xA7,0x67,0xE7,0x17,0x97,0x57,0xD7,0x37,0xB7,0x77,0xF7,
+  0x0F,0x8F,0x4F,0xCF,0x2F,0xAF,0x6F,0xEF,0x1F,0x9F,0x5F,0xDF,0x3F,0xBF,0x7F,0xFF,
+};
 
 // ---------- Ctor/Dtor ----------
 HUB12_1DATA::HUB12_1DATA(const Pins& pins, uint8_t panelsX, uint8_t panelsY, bool serpentine)
@@ -40,39 +79,123 @@ HUB12_1DATA::HUB12_1DATA(const Pins& pins, uint8_t panelsX, uint8_t panelsY, boo
   uint16_t panelsTotal = _panelsX * _panelsY;
   _bytesPerR = 16 * panelsTotal;     // 128 bits = 16 bytes por panel, por r
   _scanBytes = 4 * _bytesPerR;       // r=0..3
+
+  _dataPins[0] = _p.data;
+  _mq.attach(*this);
+}
+
+HUB12_1DATA::HUB12_1DATA(const PinsMulti& pins, uint8_t panelsX, uint8_t panelsY, bool serpentine)
+: HUB12_1DATA(Pins{pins.oe, pins.a, pins.b, pins.clk, pins.lat, pins.data[0]}, panelsX, panelsY, serpentine) {
+  _chains = pins.chains;
+  if (_chains < 1) _chains = 1;
+  if (_chains > HUB12_MAX_CHAINS) _chains = HUB12_MAX_CHAINS;
+  for (uint8_t c = 0; c < _chains; c++) _dataPins[c] = pins.data[c];
 }
 
 HUB12_1DATA::~HUB12_1DATA() {
   end();
+#if defined(ESP32)
+  if (_vsyncSem) vSemaphoreDelete(_vsyncSem);
+  if (_arParked) vSemaphoreDelete(_arParked);
+#endif
+  delete[] _mqs;
+  _mqs = nullptr;
+  if (_glyphsOwn) { free(_glyphsOwn); _glyphsOwn = nullptr; }
+  if (_atlasOwn)  { free(_atlasOwn);  _atlasOwn = nullptr; }
 }
 
 bool HUB12_1DATA::begin() {
-  if (_fb || _scanA || _scanB) end();
-
-  _fb = (uint8_t*)calloc(_fbBytes, 1);
-  if (_doubleBuffer) _fb2 = (uint8_t*)calloc(_fbBytes, 1);
-  _scanA = (uint8_t*)calloc(_scanBytes, 1);
-  _scanB = (uint8_t*)calloc(_scanBytes, 1);
-  _scanActive = _scanA;
-  if (!_fb || (_doubleBuffer && !_fb2) || !_scanA || !_scanB) {
+  if (_fb || _scan[0]) end();
+
+  const HUB12Storage* st = _storage;
+  if (!_native) {
+    _fb = takeBuffer(st ? st->fb : nullptr, _fbBytes * _planes);
+    if (_doubleBuffer) _fb2 = (uint8_t*)calloc(_fbBytes * _planes, 1);
+  }
+  // 3 del triple buffer + los de la cola de frames
+  uint8_t nb = kTbSlots + _qDepth;
+  bool bufOk = true;
+  for (uint8_t i = 0; i < nb; i++) {
+    _scan[i] = takeBuffer(st && i < kTbSlots ? st->scan[i] : nullptr, _scanBytes * _planes);
+    if (!_scan[i]) bufOk = false;
+  }
+  _tbFront = 0;
+  _showBuf = 0;
+  _tbLast = 0;
+  _tbMid.store(1);
+  _tbBack = 2;
+  _pubSeq = 0;
+  memset(_bufSeq, 0, sizeof(_bufSeq));
+  _shownSeq.store(0);
+  _vsyncCount.store(0);
+  _qHead.store(0);
+  _qTail.store(0);
+  _qFlushTo.store(0);
+  _qShowing = false;
+  _qPrevVs = micros();
+  uint32_t panelsTotal = (uint32_t)_panelsX * _panelsY;
+  _panelMap = (HUB12PanelMap*)takeBuffer((uint8_t*)(st ? st->panelMap : nullptr),
+                                         panelsTotal * sizeof(HUB12PanelMap));
+  _dirtyRows = (uint16_t*)takeBuffer((uint8_t*)(st ? st->dirtyRows : nullptr),
+                                     panelsTotal * 4 * sizeof(uint16_t));
+  _dirtyStale = _dirtyRows ? _dirtyRows + panelsTotal : nullptr;
+  _litCnt = takeBuffer(st ? st->litCnt : nullptr, panelsTotal * 4 * _planes * 3);
+  memset(_litPlane, 0, sizeof(_litPlane));
+  memset(_litRow, 0, sizeof(_litRow));
+  for (uint8_t i = 0; i < kScanBufs; i++) _litBlank[i] = 0xFFFF;   // scans en 0: todo vacío
+  // Multi-cadena: reparto exacto de paneles, sin SPI y DATA en un solo banco
+  if (_chains > 1) {
+    bool hi = _dataPins[0] >= 32;
+    bool ok = !_spiOut && ((uint32_t)_panelsX * _panelsY) % _chains == 0;
+    for (uint8_t c = 1; c < _chains; c++) if ((_dataPins[c] >= 32) != hi) ok = false;
+    if (!ok) { end(); return false; }
+
+    for (uint8_t i = 0; i < nb; i++) {
+      _slice[i] = (uint8_t*)calloc(_scanBytes * 8 / _chains * _planes, 1);
+      if (!_slice[i]) bufOk = false;
+    }
+    _sliceLut = (uint32_t*)calloc(256, sizeof(uint32_t));
+    if (!bufOk || !_sliceLut) { end(); return false; }
+  }
+
+  if (_spiOut) {
+    for (uint8_t i = 0; i < nb; i++) {
+#if defined(ESP32)
+      _tx[i] = (uint8_t*)heap_caps_calloc(_scanBytes * _planes, 1, MALLOC_CAP_DMA);
+#else
+      _tx[i] = (uint8_t*)calloc(_scanBytes * _planes, 1);
+#endif
+      if (!_tx[i]) bufOk = false;
+    }
+  }
+  if ((!_native && (!_fb || (_doubleBuffer && !_fb2))) || !bufOk ||
+      !_panelMap || !_dirtyRows || !_litCnt) {
     end();
     return false;
   }
 
     // Framebuffer pointers
-  if (_doubleBuffer) {
+  if (_native) {
+    _fb = _scan[_tbBack];   // se dibuja en el scan libre
+    _fbFront = nullptr;
+  } else if (_doubleBuffer) {
     _fbFront = _fb;   // front muestra lo actual
     _fb = _fb2;       // back para dibujar
   } else {
     _fbFront = _fb;
   }
 
-pinMode(_p.oe, OUTPUT);
+#if !defined(ARDUINO)
+  // PC: el panel virtual necesita el cableado para reconstruir la imagen
+  HUB12Host.attach(_p.oe, _p.a, _p.b, _p.clk, _p.lat, _dataPins, _chains, _panelsX, _panelsY, _serp);
+#endif
+
+  pinMode(_p.oe, OUTPUT);
   pinMode(_p.a, OUTPUT);
   pinMode(_p.b, OUTPUT);
   pinMode(_p.clk, OUTPUT);
   pinMode(_p.lat, OUTPUT);
-  pinMode(_p.data, OUTPUT);
+  for (uint8_t c = 0; c < _chains; c++) pinMode(_dataPins[c], OUTPUT);
 
   // Fast pin masks
   _fOE   = makeFastPin(_p.oe);
@@ -82,18 +205,61 @@ pinMode(_p.oe, OUTPUT);
   _fLAT  = makeFastPin(_p.lat);
   _fDATA = makeFastPin(_p.data);
 
+  if (_chains > 1) {
+    _dataMask = 0;
+    _dataHiBank = _fDATA.hiBank;
+    uint32_t bit[HUB12_MAX_CHAINS];
+    for (uint8_t c = 0; c < _chains; c++) {
+      bit[c] = makeFastPin(_dataPins[c]).mask;
+      _dataMask |= bit[c];
+    }
+    for (uint16_t v = 0; v < 256; v++) {
+      uint32_t m = 0;
+      for (uint8_t c = 0; c < _chains; c++) if (v & (1u << c)) m |= bit[c];
+      _sliceLut[v] = m;
+    }
+    // todas las cadenas en OFF (DATA activo LOW)
+    gpioSet(_dataHiBank, _dataMask);
+  }
+
   fastLow(_fCLK);
   fastLow(_fLAT);
 
+  // CLK/DATA pasan al periférico SPI (después de dejarlos en LOW)
+  if (_spiOut && !spiBegin()) {
+    end();
+    return false;
+  }
+
   // OE activo HIGH en tu panel: apagado al inicio
   fastLow(_fOE);
 
+  initScanTables();
   clear();
-  buildScan();
+  if (_native) presentNative();
+  else buildScan();
   return true;
 }
 
+// Buffer fijo (HUB12<>) puesto a 0, o calloc si no hay.
+uint8_t* HUB12_1DATA::takeBuffer(uint8_t* fixed, uint32_t bytes) {
+  if (!fixed) return (uint8_t*)calloc(bytes, 1);
+  memset(fixed, 0, bytes);
+  return fixed;
+}
+
+// true si p es uno de los buffers fijos de HUB12<> (no se liberan)
+bool HUB12_1DATA::isStorage(const void* p) const {
+  const HUB12Storage* st = _storage;
+  if (!st || !p) return false;
+  return p == st->fb || p == st->scan[0] || p == st->scan[1] || p == st->scan[2] ||
+         p == st->dirtyRows || p == st->litCnt || p == st->panelMap;
+}
+
 void HUB12_1DATA::end() {
+  // modo nativo: _fb es uno de los scan buffers, se liberan abajo
+  if (_fb && (_fb == _scan[0] || _fb == _scan[1] || _fb == _scan[2])) _fb = nullptr;
+
   // liberar framebuffers sin doble free
   uint8_t* p1 = _fb;
   uint8_t* p2 = _fb2;
@@ -102,17 +268,28 @@ void HUB12_1DATA::end() {
   if (p2 == p1) p2 = nullptr;
   if (p3 == p1 || p3 == p2) p3 = nullptr;
 
-  if (p1) free(p1);
-  if (p2) free(p2);
-  if (p3) free(p3);
+  if (p1 && !isStorage(p1)) free(p1);
+  if (p2 && !isStorage(p2)) free(p2);
+  if (p3 && !isStorage(p3)) free(p3);
 
   _fb = nullptr;
   _fb2 = nullptr;
   _fbFront = nullptr;
 
-  if (_scanA){ free(_scanA); _scanA = nullptr; }
-  if (_scanB){ free(_scanB); _scanB = nullptr; }
-  _scanActive = nullptr;
+  for (uint8_t i = 0; i < kScanBufs; i++) if (_scan[i]){ if (!isStorage(_scan[i])) free(_scan[i]); _scan[i] = nullptr; }
+  if (_panelMap){ if (!isStorage(_panelMap)) free(_panelMap); _panelMap = nullptr; }
+  if (_dirtyRows){ if (!isStorage(_dirtyRows)) free(_dirtyRows); _dirtyRows = nullptr; _dirtyStale = nullptr; }
+  if (_litCnt){ if (!isStorage(_litCnt)) free(_litCnt); _litCnt = nullptr; }
+
+  spiEnd();
+  for (uint8_t i = 0; i < kScanBufs; i++) {
+    if (_tx[i]){ free(_tx[i]); _tx[i] = nullptr; }
+    if (_slice[i]){ free(_slice[i]); _slice[i] = nullptr; }
+  }
+  if (_sliceLut){ free(_sliceLut); _sliceLut = nullptr; }
+
+  // Las páginas dependen de la geometría del scan
+  freePages();
 }
 
 
@@ -121,10 +298,11 @@ void HUB12_1DATA::setDoubleBuffer(bool enable) {
 
   // Si aún no se ha llamado begin(), solo guardamos el flag.
   if (!_fb && !_fb2) return;
+  if (_native) return;
 
   if (_doubleBuffer) {
     if (!_fb2) {
-      _fb2 = (uint8_t*)calloc(_fbBytes, 1);
+      _fb2 = (uint8_t*)calloc(_fbBytes * _planes, 1);
       if (!_fb2) { _doubleBuffer = false; _fbFront = _fb; return; }
     }
     // Mantener lo visible en front, y usar el otro como back.
@@ -133,29 +311,62 @@ void HUB12_1DATA::setDoubleBuffer(bool enable) {
       _fb = _fb2; // back para dibujar
     }
   } else {
-    // Pasar a single buffer: copiar lo visible al buffer único
+    // Pasar a single buffer: queda el buffer original (puede ser el fijo de
+    // HUB12<>) con lo visible; se libera _fb2 aunque sea el de dibujo.
+    if (_fb2 && _fb == _fb2) _fb = _fbFront;
     if (_fbFront && _fbFront != _fb) {
-      memcpy(_fb, _fbFront, _fbBytes);
+      memcpy(_fb, _fbFront, _fbBytes * _planes);
     }
     if (_fb2) { free(_fb2); _fb2 = nullptr; }
     _fbFront = _fb;
   }
 
-  _dirty = true;
+  markAllDirty();
 }
 
 bool HUB12_1DATA::isDoubleBuffer() const {
   return _doubleBuffer;
 }
 
+bool HUB12_1DATA::setPanelNative(bool enable) {
+  if (_scan[0]) return false;
+  if (enable && _planes > 1) return false;   // el scan nativo es de un solo plano
+  _native = enable;
+  return true;
+}
+
+bool HUB12_1DATA::setGrayscale(uint8_t bits) {
+  if (_scan[0]) return false;
+  if (bits < 1 || bits > 4) return false;
+  if (bits > 1 && _native) return false;
+  if (_storage && bits != _storage->planes) return false;
+  _planes = bits;
+  _drawLevel = maxLevel();
+  return true;
+}
+
+bool HUB12_1DATA::setSpiOutput(bool enable, uint32_t clockHz) {
+  if (_scan[0]) return false;
+#if defined(ESP32)
+  _spiOut = enable;
+  _spiHz = clockHz;
+  return true;
+#else
+  (void)clockHz;
+  return !enable;
+#endif
+}
+
 void HUB12_1DATA::swapBuffers(bool copyFrontToBack) {
+  if (_native) return;
   if (!_doubleBuffer) { _fbFront = _fb; return; }
   uint8_t* tmp = _fbFront;
   _fbFront = _fb;
   _fb = tmp;
   if (copyFrontToBack && _fb && _fbFront) {
-    memcpy(_fb, _fbFront, _fbBytes);
+    memcpy(_fb, _fbFront, _fbBytes * _planes);
   }
+  markAllDirty();
 }
 
 // ---------- Fast low-level ----------
@@ -174,13 +385,39 @@ inline void HUB12_1DATA::writeData(bool on) {
 }
 
 // ---------- Framebuffer ----------
+// Modo nativo: (x,y) -> byte/bit del scan. Es xyToBitIndexLocal() + mapGlobalToChain()
+// resueltos con shifts: byte = r*_bytesPerR + panel*16 + (lx/8)*4 + sub, MSB-first.
+inline uint32_t HUB12_1DATA::nativeIndex(int x, int y, uint8_t& mask) const {
+  uint16_t px = x >> 5, py = y >> 4;
+  uint8_t lx = x & 31, ly = y & 15;
+  if (_serp && (py & 1)) { px = _panelsX - 1 - px; lx = 31 - lx; }
+
+  mask = 0x80 >> (lx & 7);
+  return (uint32_t)(ly & 3) * _bytesPerR + ((uint32_t)py * _panelsX + px) * 16 +
+         (uint32_t)(lx >> 3) * 4 + (3 - (ly >> 2));
+}
+
 inline bool HUB12_1DATA::fbGet(int x, int y) const {
+  if (_native) {
+    uint8_t m;
+    return _fb[nativeIndex(x, y, m)] & m;
+  }
   uint32_t idx = (uint32_t)y * _w + (uint32_t)x;
   uint8_t* src = _fbFront ? _fbFront : _fb;
-  return (src[idx >> 3] >> (idx & 7)) & 1;
+  for (uint8_t k = 0; k < _planes; k++, src += _fbBytes)
+    if ((src[idx >> 3] >> (idx & 7)) & 1) return true;
+  return false;
 }
 
 inline void HUB12_1DATA::fbSet(int x, int y, bool on) {
+  if (_native) {
+    uint8_t m;
+    uint32_t b = nativeIndex(x, y, m);
+    if (on) _fb[b] |= m;
+    else    _fb[b] &= ~m;
+    return;
+  }
+  if (_planes > 1) { fbSetLevel(x, y, on ? _drawLevel : 0); return; }
   uint32_t idx = (uint32_t)y * _w + (uint32_t)x;
   uint32_t b = idx >> 3;
   uint8_t bit = idx & 7;
@@ -188,9 +425,46 @@ inline void HUB12_1DATA::fbSet(int x, int y, bool on) {
   else    _fb[b] &= ~(1 << bit);
 }
 
-void HUB12_1DATA::clear() {
-  memset(_fb, 0, _fbBytes);
+// Escala de grises: bit k del nivel -> plano k.
+inline void HUB12_1DATA::fbSetLevel(int x, int y, uint8_t level) {
+  uint32_t idx = (uint32_t)y * _w + (uint32_t)x;
+  uint8_t* p = _fb + (idx >> 3);
+  uint8_t m = (uint8_t)(1 << (idx & 7));
+  for (uint8_t k = 0; k < _planes; k++, p += _fbBytes, level >>= 1) {
+    if (level & 1) *p |= m;
+    else           *p &= ~m;
+  }
+}
+
+// ---------- DirtyRect ----------
+void HUB12_1DATA::markDirty(int x0, int y0, int x1, int y1) {
   _dirty = true;
+  if (!_dirtyRows) return;
+
+  for (int py = y0 >> 4; py <= (y1 >> 4); py++) {
+    int lo = (y0 > py * 16) ? y0 - py * 16 : 0;
+    int hi = (y1 < py * 16 + 15) ? y1 - py * 16 : 15;
+    uint16_t bits = (uint16_t)(((1u << (hi + 1)) - 1) & ~((1u << lo) - 1));
+
+    uint16_t* row = _dirtyRows + py * _panelsX;
+    for (int px = x0 >> 5; px <= (x1 >> 5); px++) row[px] |= bits;
+  }
+}
+
+void HUB12_1DATA::markAllDirty() {
+  _dirty = true;
+  if (!_dirtyRows) return;
+  uint16_t panelsTotal = _panelsX * _panelsY;
+  for (uint16_t i = 0; i < panelsTotal; i++) _dirtyRows[i] = 0xFFFF;
+}
+
+void HUB12_1DATA::invalidate() {
+  markAllDirty();
+}
+
+void HUB12_1DATA::clear() {
+  memset(_fb, 0, _fbBytes * _planes);
+  markAllDirty();
 }
 
 void HUB12_1DATA::drawPixel(int x, int y, bool on) {
@@ -202,6 +476,7 @@ if (_clipEnabled) {
 }
 
   fbSet(x, y, on);
+  if (_dirtyRows) _dirtyRows[(y >> 4) * _panelsX + (x >> 5)] |= (uint16_t)(1u << (y & 15));
   _dirty = true;
 }
 
@@ -210,27 +485,90 @@ bool HUB12_1DATA::getPixel(int x, int y) const {
   return fbGet(x, y);
 }
 
+uint8_t HUB12_1DATA::getPixelLevel(int x, int y) const {
+  if (x < 0 || y < 0 || x >= (int)_w || y >= (int)_h) return 0;
+  if (_native || _planes == 1) return fbGet(x, y) ? 1 : 0;
+  uint32_t idx = (uint32_t)y * _w + (uint32_t)x;
+  const uint8_t* src = (_fbFront ? _fbFront : _fb) + (idx >> 3);
+  uint8_t level = 0;
+  for (uint8_t k = 0; k < _planes; k++, src += _fbBytes)
+    if ((*src >> (idx & 7)) & 1) level |= (uint8_t)(1 << k);
+  return level;
+}
+
+// ---------- Kernels de tramo (framebuffer lineal) ----------
+// Cada fila son _w/32 palabras alineadas; el ESP32 es little-endian, así que el
+// bit k de una palabra es el pixel k de ese bloque de 32 (mismo orden que fbSet).
+// Reciben coordenadas ya recortadas; en modo nativo caen a fbSet().
+inline void HUB12_1DATA::fbSpan(int y, int x0, int x1, bool on) {
+  if (_native) {
+    for (int i = x0; i <= x1; i++) fbSet(i, y, on);
+    return;
+  }
+
+  uint8_t* base = _fb + (uint32_t)y * (_w >> 3);
+  int w0 = x0 >> 5, w1 = x1 >> 5;
+  uint32_t head = 0xFFFFFFFFu << (x0 & 31);
+  uint32_t tail = 0xFFFFFFFFu >> (31 - (x1 & 31));
+  if (w0 == w1) head &= tail;
+
+  // Escala de grises: el mismo tramo en cada plano, con el bit k de _drawLevel
+  for (uint8_t k = 0; k < _planes; k++, base += _fbBytes) {
+    uint32_t* row = (uint32_t*)base;
+    bool v = on && ((_drawLevel >> k) & 1);
+    if (w0 == w1) {
+      if (v) row[w0] |= head; else row[w0] &= ~head;
+    } else if (v) {
+      row[w0] |= head;
+      for (int i = w0 + 1; i < w1; i++) row[i] = 0xFFFFFFFFu;
+      row[w1] |= tail;
+    } else {
+      row[w0] &= ~head;
+      for (int i = w0 + 1; i < w1; i++) row[i] = 0;
+      row[w1] &= ~tail;
+    }
+  }
+}
+
+inline void HUB12_1DATA::fbVSpan(int x, int y0, int y1, bool on) {
+  if (_native) {
+    for (int i = y0; i <= y1; i++) fbSet(x, i, on);
+    return;
+  }
+
+  uint32_t stride = _w >> 3;
+  uint8_t* base = _fb + (uint32_t)y0 * stride + ((uint32_t)x >> 3);
+  uint8_t m = (uint8_t)(1 << (x & 7));
+  for (uint8_t k = 0; k < _planes; k++, base += _fbBytes) {
+    uint8_t* p = base;
+    if (on && ((_drawLevel >> k) & 1)) { for (int i = y0; i <= y1; i++, p += stride) *p |= m; }
+    else                               { for (int i = y0; i <= y1; i++, p += stride) *p &= ~m; }
+  }
+}
+
 // ---------- Primitivas ----------
 void HUB12_1DATA::drawFastHLine(int x, int y, int w, bool on) {
   if (y < 0 || y >= (int)_h) return;
   if (w < 0) { x += w; w = -w; }
+  if (w == 0) return;
   int x2 = x + w - 1;
   if (x2 < 0 || x >= (int)_w) return;
   if (x < 0) x = 0;
   if (x2 >= (int)_w) x2 = _w - 1;
-  for (int i = x; i <= x2; i++) fbSet(i, y, on);
-  _dirty = true;
+  fbSpan(y, x, x2, on);
+  markDirty(x, y, x2, y);
 }
 
 void HUB12_1DATA::drawFastVLine(int x, int y, int h, bool on) {
   if (x < 0 || x >= (int)_w) return;
   if (h < 0) { y += h; h = -h; }
+  if (h == 0) return;
   int y2 = y + h - 1;
   if (y2 < 0 || y >= (int)_h) return;
   if (y < 0) y = 0;
   if (y2 >= (int)_h) y2 = _h - 1;
-  for (int i = y; i <= y2; i++) fbSet(x, i, on);
-  _dirty = true;
+  fbVSpan(x, y, y2, on);
+  markDirty(x, y, x, y2);
 }
 
 void HUB12_1DATA::drawRect(int x, int y, int w, int h, bool on) {
@@ -242,8 +580,19 @@ void HUB12_1DATA::drawRect(int x, int y, int w, int h, bool on) {
 }
 
 void HUB12_1DATA::fillRect(int x, int y, int w, int h, bool on) {
-  for (int yy = 0; yy < h; yy++) drawFastHLine(x, y + yy, w, on);
-  _dirty = true;
+  // Recorte una sola vez para todo el rectángulo (w<0 invierte igual que drawFastHLine)
+  if (h <= 0 || w == 0) return;
+  if (w < 0) { x += w; w = -w; }
+  int x2 = x + w - 1;
+  int y2 = y + h - 1;
+  if (x2 < 0 || y2 < 0 || x >= (int)_w || y >= (int)_h) return;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x2 >= (int)_w) x2 = _w - 1;
+  if (y2 >= (int)_h) y2 = _h - 1;
+
+  for (int yy = y; yy <= y2; yy++) fbSpan(yy, x, x2, on);
+  markDirty(x, y, x2, y2);
 }
 
 // Bresenham
@@ -253,7 +602,11 @@ void HUB12_1DATA::drawLine(int x0, int y0, int x1, int y1, bool on) {
   int err = dx + dy;
 
   while (true) {
-    fbSet(x0, y0, on);
+    // Recorta solo a pantalla: como las líneas H/V, no mira setClipRect()
+    if (x0 >= 0 && y0 >= 0 && x0 < (int)_w && y0 < (int)_h) {
+      fbSet(x0, y0, on);
+      if (_dirtyRows) _dirtyRows[(y0 >> 4) * _panelsX + (x0 >> 5)] |= (uint16_t)(1u << (y0 & 15));
+    }
     if (x0 == x1 && y0 == y1) break;
     int e2 = 2 * err;
     if (e2 >= dy) { err += dy; x0 += sx; }
@@ -262,6 +615,236 @@ void HUB12_1DATA::drawLine(int x0, int y0, int x1, int y1, bool on) {
   _dirty = true;
 }
 
+// ---------- Scroll de región ----------
+void HUB12_1DATA::scrollLeft(int x, int y, int w, int h, int px) {
+  if (!_fb || w <= 0 || h <= 0 || px <= 0) return;
+  int x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 >= (int)_w) x1 = _w - 1;
+  if (y1 >= (int)_h) y1 = _h - 1;
+  if (x0 > x1 || y0 > y1) return;
+
+  int keep = x1 - x0 + 1 - px;   // columnas que se conservan (corridas a x0)
+  if (keep > 0) {
+    if (_native) {
+      for (int yy = y0; yy <= y1; yy++)
+        for (int xx = x0; xx < x0 + keep; xx++) fbSet(xx, yy, fbGet(xx + px, yy));
+    } else {
+      uint32_t wpr = _w >> 5;
+      for (uint8_t k = 0; k < _planes; k++) {   // cada plano (escala de grises)
+        uint32_t* plane = (uint32_t*)(_fb + (uint32_t)k * _fbBytes);
+        for (int yy = y0; yy <= y1; yy++) {
+          uint32_t* row = plane + (uint32_t)yy * wpr;
+          // Tramos alineados a palabras destino; el origen (a+px) siempre está más a la
+          // derecha que lo ya escrito, así que se puede hacer en el mismo buffer.
+          for (int a = x0; a < x0 + keep; a = (a | 31) + 1) {
+            int b = a | 31;
+            if (b > x0 + keep - 1) b = x0 + keep - 1;
+            uint32_t m = (0xFFFFFFFFu << (a & 31)) & (0xFFFFFFFFu >> (31 - (b & 31)));
+
+            int c = a + px;                       // primera columna de origen
+            uint32_t i = (uint32_t)c >> 5, sh = c & 31;
+            uint32_t v = row[i] >> sh;
+            if (sh && i + 1 < wpr) v |= row[i + 1] << (32 - sh);
+
+            uint32_t& dw = row[a >> 5];
+            dw = (dw & ~m) | ((v << (a & 31)) & m);
+          }
+        }
+      }
+    }
+  }
+
+  int c0 = (keep > 0) ? x0 + keep : x0;
+  for (int yy = y0; yy <= y1; yy++) fbSpan(yy, c0, x1, false);
+  markDirty(x0, y0, x1, y1);
+}
+
+// ---------- Bitmaps (blit con operaciones raster) ----------
+// Intersección de [x0..x1]x[y0..y1] con pantalla y clip; false si queda vacía.
+bool HUB12_1DATA::clipBox(int& x0, int& y0, int& x1, int& y1) const {
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 >= (int)_w) x1 = _w - 1;
+  if (y1 >= (int)_h) y1 = _h - 1;
+  if (_clipEnabled) {
+    if (x0 < _clipX0) x0 = _clipX0;
+    if (y0 < _clipY0) y0 = _clipY0;
+    if (x1 > _clipX1) x1 = _clipX1;
+    if (y1 > _clipY1) y1 = _clipY1;
+  }
+  return x0 <= x1 && y0 <= y1;
+}
+
+// n (1..32) bits de una fila del bitmap desde la columna col (bit 0 = col), LSB
+// primero. Lee solo los bytes que tocan el tramo (máx. 5); los bits de más no se usan.
+template <bool LSB>
+static inline uint32_t srcBits(const uint8_t* row, int col, int n) {
+  const uint8_t* p = row + (col >> 3);
+  int bytes = ((col & 7) + n + 7) >> 3;
+  uint64_t v = 0;
+  for (int k = 0; k < bytes; k++) {
+    uint8_t c = pgm_read_byte(p + k);
+    v |= (uint64_t)(LSB ? c : kRev8[c]) << (8 * k);
+  }
+  return (uint32_t)(v >> (col & 7));
+}
+
+// Única definición de las raster ops: bits de s bajo la máscara m sobre d.
+template <uint8_t OP>
+static inline uint32_t ropWord(uint32_t d, uint32_t s, uint32_t m) {
+  switch (OP) {
+    case HUB12_1DATA::ROP_COPY:   return (d & ~m) | (s & m);
+    case HUB12_1DATA::ROP_OR:     return d | (s & m);
+    case HUB12_1DATA::ROP_AND:    return d & (s | ~m);
+    case HUB12_1DATA::ROP_XOR:    return d ^ (s & m);
+    case HUB12_1DATA::ROP_ANDNOT: return d & ~(s & m);
+  }
+  return d;
+}
+
+// Filas [y0..y1], columnas [x0..x1] ya recortadas; (x,y) = esquina del bitmap.
+// Tramos de hasta 32 columnas: los bits de origen se desplazan a su columna y
+// caen en 1 o 2 palabras del framebuffer. Máscaras y desplazamientos se calculan
+// una vez por tramo y se reusan en todas las filas.
+template <uint8_t OP, bool LSB>
+static void blitRows(uint32_t* fb, uint32_t wordsPerRow, int x, int y, int x0, int y0, int x1, int y1,
+                     const uint8_t* src, uint16_t srcStride) {
+  for (int a = x0; a <= x1; a += 32) {
+    int n = (x1 - a + 1 < 32) ? x1 - a + 1 : 32;
+    uint8_t sh = a & 31;
+    uint32_t mLo = (0xFFFFFFFFu >> (32 - n)) << sh;
+    uint32_t mHi = (sh + n > 32) ? (0xFFFFFFFFu >> (32 - n)) >> (32 - sh) : 0;
+
+    const uint8_t* row = src + (uint32_t)(y0 - y) * srcStride;
+    uint32_t* d = fb + (uint32_t)y0 * wordsPerRow + (a >> 5);
+    uint64_t v0 = (uint64_t)srcBits<LSB>(row, a - x, n) << sh;   // srcStride 0: misma fila
+    for (int yy = y0; yy <= y1; yy++, row += srcStride, d += wordsPerRow) {
+      uint64_t v = (yy == y0 || !srcStride) ? v0 : (uint64_t)srcBits<LSB>(row, a - x, n) << sh;
+      d[0] = ropWord<OP>(d[0], (uint32_t)v, mLo);
+      if (mHi) d[1] = ropWord<OP>(d[1], (uint32_t)(v >> 32), mHi);
+    }
+  }
+}
+
+// Versión con op en runtime (modo nativo, pixel a pixel): despacha a ropWord<OP>.
+static inline uint32_t applyRop(uint32_t d, uint32_t s, uint32_t m, uint8_t op) {
+  switch (op) {
+    case HUB12_1DATA::ROP_COPY:   return ropWord<HUB12_1DATA::ROP_COPY>(d, s, m);
+    case HUB12_1DATA::ROP_OR:     return ropWord<HUB12_1DATA::ROP_OR>(d, s, m);
+    case HUB12_1DATA::ROP_AND:    return ropWord<HUB12_1DATA::ROP_AND>(d, s, m);
+    case HUB12_1DATA::ROP_XOR:    return ropWord<HUB12_1DATA::ROP_XOR>(d, s, m);
+    case HUB12_1DATA::ROP_ANDNOT: return ropWord<HUB12_1DATA::ROP_ANDNOT>(d, s, m);
+  }
+  return d;
+}
+
+void HUB12_1DATA::blit(int x, int y, const uint8_t* src, int w, int h, RasterOp op,
+                       uint16_t srcStride, bool lsbFirst) {
+  if (w <= 0) return;
+  if (!srcStride) srcStride = (uint16_t)((w + 7) >> 3);
+  blitRaw(x, y, src, w, h, op, srcStride, lsbFirst, true);
+}
+
+// Escala de grises: un bit 1 del bitmap pinta _drawLevel. Por plano eso es, según
+// el bit k del nivel: COPY -> COPY o rect en 0, OR -> OR o ANDNOT, XOR -> XOR o
+// nada. AND y ANDNOT no dependen del nivel.
+static const uint8_t kRopClear = 0xFE;
+static const uint8_t kRopNop   = 0xFF;
+
+uint8_t HUB12_1DATA::planeRop(RasterOp op, uint8_t plane) const {
+  bool bit = (_drawLevel >> plane) & 1;
+  switch (op) {
+    case ROP_COPY: return bit ? (uint8_t)ROP_COPY : kRopClear;
+    case ROP_OR:   return bit ? (uint8_t)ROP_OR : (uint8_t)ROP_ANDNOT;
+    case ROP_XOR:  return bit ? (uint8_t)ROP_XOR : kRopNop;
+    default:       return (uint8_t)op;
+  }
+}
+
+// srcStride = 0 repite la misma fila h veces. useClip=false recorta solo a pantalla.
+void HUB12_1DATA::blitRaw(int x, int y, const uint8_t* src, int w, int h, RasterOp op,
+                          uint16_t srcStride, bool lsbFirst, bool useClip, int8_t plane) {
+  if (!_fb || !src || w <= 0 || h <= 0) return;
+
+  int x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+  if (useClip) {
+    if (!clipBox(x0, y0, x1, y1)) return;
+  } else {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= (int)_w) x1 = _w - 1;
+    if (y1 >= (int)_h) y1 = _h - 1;
+    if (x0 > x1 || y0 > y1) return;
+  }
+
+  if (_native) {
+    // orden de scan: sin palabras contiguas, pixel a pixel
+    for (int yy = y0; yy <= y1; yy++) {
+      const uint8_t* row = src + (uint32_t)(yy - y) * srcStride;
+      for (int xx = x0; xx <= x1; xx++) {
+        uint32_t d = fbGet(xx, yy) ? 1u : 0u;
+        uint32_t sb = (lsbFirst ? srcBits<true>(row, xx - x, 1) : srcBits<false>(row, xx - x, 1)) & 1u;
+        fbSet(xx, yy, applyRop(d, sb, 1u, op) & 1u);
+      }
+    }
+    markDirty(x0, y0, x1, y1);
+    return;
+  }
+
+  uint32_t wpr = _w >> 5;
+#define HUB12_BLIT(OP) (lsbFirst ? blitRows<OP, true>(fb, wpr, x, y, x0, y0, x1, y1, src, srcStride) \
+                                 : blitRows<OP, false>(fb, wpr, x, y, x0, y0, x1, y1, src, srcStride))
+  for (uint8_t k = 0; k < _planes; k++) {
+    if (plane >= 0 && k != (uint8_t)plane) continue;
+    uint32_t* fb = (uint32_t*)(_fb + (uint32_t)k * _fbBytes);
+    uint8_t pop = (plane >= 0 || _planes == 1) ? (uint8_t)op : planeRop(op, k);
+    switch (pop) {
+      case ROP_COPY:   HUB12_BLIT(ROP_COPY); break;
+      case ROP_OR:     HUB12_BLIT(ROP_OR); break;
+      case ROP_AND:    HUB12_BLIT(ROP_AND); break;
+      case ROP_XOR:    HUB12_BLIT(ROP_XOR); break;
+      case ROP_ANDNOT: HUB12_BLIT(ROP_ANDNOT); break;
+      case kRopClear:
+        for (int yy = y0; yy <= y1; yy++) {
+          uint32_t* row = fb + (uint32_t)yy * wpr;
+          for (int a = x0; a <= x1; a = (a | 31) + 1) {
+            int b = ((a | 31) < x1) ? (a | 31) : x1;
+            row[a >> 5] &= ~((0xFFFFFFFFu << (a & 31)) & (0xFFFFFFFFu >> (31 - (b & 31))));
+          }
+        }
+        break;
+    }
+  }
+#undef HUB12_BLIT
+  markDirty(x0, y0, x1, y1);
+}
+
+void HUB12_1DATA::drawBitmap(int x, int y, const uint8_t* bmp, int w, int h, bool on) {
+  blit(x, y, bmp, w, h, on ? ROP_OR : ROP_ANDNOT);
+}
+
+// Un byte por pixel; en monocromo cualquier valor > 127 enciende.
+void HUB12_1DATA::drawGrayBitmap(int x, int y, const uint8_t* bmp, int w, int h) {
+  if (!_fb || !bmp || w <= 0 || h <= 0) return;
+  int x0 = x, y0 = y, x1 = x + w - 1, y1 = y + h - 1;
+  if (!clipBox(x0, y0, x1, y1)) return;
+
+  uint8_t max = maxLevel();
+  for (int yy = y0; yy <= y1; yy++) {
+    const uint8_t* row = bmp + (uint32_t)(yy - y) * w;
+    for (int xx = x0; xx <= x1; xx++) {
+      uint8_t v = pgm_read_byte(row + (xx - x));
+      uint8_t level = (uint8_t)(((uint16_t)v * max + 127) / 255);
+      if (!level) continue;
+      if (_planes > 1) fbSetLevel(xx, yy, level);
+      else             fbSet(xx, yy, true);
+    }
+  }
+  markDirty(x0, y0, x1, y1);
+}
+
 // ---------- Mapeo local (32x16) confirmado ----------
 int HUB12_1DATA::xyToBitIndexLocal(int x, int y) {
   // patrón confirmado por el barrido de bits:
@@ -292,96 +875,897 @@ void HUB12_1DATA::mapGlobalToChain(int gx, int gy, uint8_t& panelIdx, int& lx, i
     return;
   }
 
-  // Serpentina: filas alternadas
-  if ((py & 1) == 0) {
-    panelIdx = py * _panelsX + px;
+  // Serpentina: filas alternadas
+  if ((py & 1) == 0) {
+    panelIdx = py * _panelsX + px;
+  } else {
+    panelIdx = py * _panelsX + (_panelsX - 1 - px);
+    lx = 31 - lx; // invierte X local para mantener coordenadas globales rectas
+  }
+}
+
+// ---------- Tablas de scan ----------
+// Cada byte del scan corresponde a 8 px horizontales alineados de una sola fila del panel,
+// o sea a un byte del framebuffer. Para el byte j de la fila r del panel:
+//   g = j >> 2 (grupo de 8 px), sub = j & 3, ly = (3 - sub) * 4 + r
+// (inverso de xyToBitIndexLocal()).
+void HUB12_1DATA::initScanTables() {
+  uint32_t rowBytes = _w >> 3;
+
+  for (uint8_t r = 0; r < 4; r++) {
+    for (uint8_t j = 0; j < 16; j++) {
+      uint8_t g   = j >> 2;
+      uint8_t sub = j & 3;
+      uint8_t ly  = (3 - sub) * 4 + r;
+      _scanLut[r * 16 + j] = (uint16_t)(ly * rowBytes + g);
+    }
+  }
+
+  // Orden de cadena -> posición en el framebuffer (misma regla que mapGlobalToChain)
+  uint16_t panelsTotal = _panelsX * _panelsY;
+  for (uint16_t i = 0; i < panelsTotal; i++) {
+    uint8_t py = i / _panelsX;
+    uint8_t px = i % _panelsX;
+    bool mirror = _serp && (py & 1);
+    if (mirror) px = _panelsX - 1 - px;
+
+    _panelMap[i].fbOfs = (uint32_t)py * 16 * rowBytes + (uint32_t)px * 4;
+    _panelMap[i].mirror = mirror;
+    _panelMap[i].fbPanel = (uint16_t)py * _panelsX + px;
+  }
+}
+
+// ---------- Conteo de LEDs por fila (limitador) ----------
+// LEDs encendidos en un bloque de 16 bytes del scan (un panel, una fila).
+static inline uint8_t popcount16(const uint8_t* p) {
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    uint32_t v = ((const uint32_t*)p)[i];
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    n += (uint8_t)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+  }
+  return n;
+}
+
+uint8_t* HUB12_1DATA::litCounts(uint8_t buf) const {
+  return _litCnt + (uint32_t)buf * _panelsX * _panelsY * 4 * _planes;
+}
+
+// Recuenta el bloque (panel i, fila r, plano k) del scan 'buf' y ajusta el total.
+inline void HUB12_1DATA::countLit(uint8_t buf, uint8_t k, uint8_t r, uint16_t i, const uint8_t* block) {
+  uint8_t& c = litCounts(buf)[((uint32_t)k * 4 + r) * _panelsX * _panelsY + i];
+  uint8_t n = popcount16(block);
+  _litPlane[buf][k * 4 + r] += (uint32_t)n - c;
+  c = n;
+}
+
+// Totales por fila del scan 'buf' (ponderados por plano) y filas vacías.
+void HUB12_1DATA::sumLit(uint8_t buf) {
+  uint32_t lit[4] = { 0, 0, 0, 0 };
+  uint16_t blank = 0;
+  for (uint8_t k = 0; k < _planes; k++) {
+    for (uint8_t r = 0; r < 4; r++) {
+      uint32_t n = _litPlane[buf][k * 4 + r];
+      if (!n) blank |= (uint16_t)(1u << (r * 4 + k));
+      lit[r] += n << k;
+    }
+  }
+  for (uint8_t r = 0; r < 4; r++) _litRow[buf][r] = lit[r];
+  _litBlank[buf] = blank;
+}
+
+// Tiempo ON de la fila r con el limitador (us = tiempo del plano sin limitar).
+uint32_t HUB12_1DATA::rowOnUs(uint8_t buf, uint8_t r, uint32_t us) const {
+  uint32_t lit = _litRow[buf][r];
+  if (!_powerLeds || !lit) return us;
+  uint64_t on = (uint64_t)us * _powerLeds * maxLevel() / lit;   // lit va en unidades de peso
+  uint64_t lim = us;
+  if (_onTimeUs && _powerMaxUs > _onTimeUs) lim = (uint64_t)us * _powerMaxUs / _onTimeUs;
+  return (uint32_t)(on < lim ? on : lim);
+}
+
+uint32_t HUB12_1DATA::rowLit(uint8_t r) const {
+  if (!_scan[0] || r > 3) return 0;
+  return _litRow[_tbLast][r] / maxLevel();
+}
+
+// ---------- Scan build (por bytes, con tablas) ----------
+// Construye en el buffer "back" (propiedad exclusiva del productor) y lo publica.
+void HUB12_1DATA::buildScan() {
+  if (_native || !_scan[0]) return;
+  unsigned long t0 = _statsOn ? micros() : 0;
+
+  renderBack();
+  publishScan();
+
+  if (_statsOn) statBuild(micros() - t0);
+}
+
+// Deja el back completo (scan, conteos y stream de salida) sin publicarlo.
+// Solo re-codifica las filas marcadas en _dirtyRows más las que cambiaron desde
+// la última vez que se construyó este buffer (_dirtyStale de ese buffer). En modo
+// nativo el back ya es lo dibujado: solo se cuentan las filas tocadas.
+void HUB12_1DATA::renderBack() {
+  uint8_t buf = _tbBack;
+  uint8_t* out = _scan[buf];
+  uint16_t panelsTotal = _panelsX * _panelsY;
+
+  if (_native) {
+    for (uint16_t i = 0; i < panelsTotal; i++) {
+      uint16_t rows = _dirtyRows[_panelMap[i].fbPanel];
+      if (!rows) continue;
+      for (uint8_t r = 0; r < 4; r++)
+        if (rows & (0x1111u << r)) countLit(buf, 0, r, i, out + (uint32_t)r * _bytesPerR + (uint32_t)i * 16);
+    }
+    sumLit(buf);
+    encodeOutput(buf);
+    markStale(buf);
+    _dirty = false;
+    return;
+  }
+
+  const uint8_t* src = _fbFront ? _fbFront : _fb;
+  // HUB12<>: mismo recorrido con la geometría fija en compilación
+  if (_buildRowsFn) _buildRowsFn(*this, buf, src);
+  else buildRows(buf, src);
+
+  sumLit(buf);
+  encodeOutput(buf);
+  markStale(buf);
+  _dirty = false;
+}
+
+// Filas sucias de todos los paneles: framebuffer -> scan 'buf' y conteos.
+void HUB12_1DATA::buildRows(uint8_t buf, const uint8_t* src) {
+  uint8_t* out = _scan[buf];
+  uint16_t panelsTotal = _panelsX * _panelsY;
+  const uint16_t* stale = _dirtyStale + (uint32_t)buf * panelsTotal;
+
+  // Escala de grises: un juego de 4 filas por plano, plano k en out + k*_scanBytes
+  for (uint8_t k = 0; k < _planes; k++) {
+    const uint8_t* ps = src + (uint32_t)k * _fbBytes;
+    uint8_t* po = out + (uint32_t)k * _scanBytes;
+    for (uint16_t i = 0; i < panelsTotal; i++) {
+      const HUB12PanelMap& pm = _panelMap[i];
+      uint16_t rows = _dirtyRows[pm.fbPanel] | stale[pm.fbPanel];
+      if (!rows) continue;
+
+      const uint8_t* pb = ps + pm.fbOfs;
+      uint8_t gx = pm.mirror ? 3 : 0;  // panel invertido: grupo g <- 3-g (rowBytes es múltiplo de 4)
+
+      for (uint8_t r = 0; r < 4; r++) {
+        const uint16_t* lut = _scanLut + r * 16;
+        uint8_t* dst = po + (uint32_t)r * _bytesPerR + (uint32_t)i * 16;
+
+        for (uint8_t sub = 0; sub < 4; sub++) {
+          uint8_t ly = (3 - sub) * 4 + r;
+          if (!(rows & (1u << ly))) continue;
+
+          // bytes j = g*4 + sub de la fila r: los 4 grupos de 8 px de la fila ly
+          for (uint8_t j = sub; j < 16; j += 4) {
+            uint8_t v = pb[lut[j] ^ gx];
+            // Panel invertido: los 8 px ya quedan MSB-first, no se invierten los bits.
+            dst[j] = pm.mirror ? v : kRev8[v];
+          }
+        }
+        if (rows & (0x1111u << r)) countLit(buf, k, r, i, dst);
+      }
+    }
+  }
+}
+
+// Para HUB12<>: countLit es inline en este archivo
+void HUB12_1DATA::countBlock(uint8_t buf, uint8_t k, uint8_t r, uint16_t i, const uint8_t* block) {
+  countLit(buf, k, r, i, block);
+}
+
+const uint8_t* HUB12_1DATA::rev8Table() {
+  return kRev8;
+}
+
+// ---------- Triple buffer de scan ----------
+// _scan[_tbBack] es del productor (update), _scan[_tbFront] del consumidor
+// (refresh) y _tbMid es el último frame publicado, con kTbFresh si el consumidor
+// aún no lo tomó. Cada lado solo toca su buffer; el traspaso es un exchange.
+void HUB12_1DATA::publishScan() {
+#if defined(ESP32)
+  uint32_t c0 = statCycles();
+#endif
+  _tbLast = _tbBack;
+  _needsPublish = false;
+  _bufSeq[_tbBack] = ++_pubSeq;
+  _tbBack = (uint8_t)(_tbMid.exchange(_tbBack | kTbFresh, std::memory_order_acq_rel) & 3);
+#if defined(ESP32)
+  if (_statsOn) statLock(statCycles() - c0);
+#endif
+}
+
+// Solo al empezar un ciclo: si hay frame nuevo, se cambia por el front actual.
+uint8_t HUB12_1DATA::acquireScan() {
+  if (_tbMid.load(std::memory_order_relaxed) & kTbFresh) {
+#if defined(ESP32)
+    uint32_t c0 = statCycles();
+#endif
+    _tbFront = (uint8_t)(_tbMid.exchange(_tbFront, std::memory_order_acq_rel) & 3);
+#if defined(ESP32)
+    if (_statsOn) statLock(statCycles() - c0);
+#endif
+  }
+  return _tbFront;
+}
+
+// Inicio de ciclo: frame en vivo del triple buffer o, con cola, el último vencido.
+uint8_t HUB12_1DATA::beginCycle() {
+  bool fresh = (_tbMid.load(std::memory_order_relaxed) & kTbFresh) != 0;
+  uint8_t buf = acquireScan();
+  if (_qDepth) buf = pickQueued(buf, fresh);
+  _showBuf = buf;
+  signalVSync();
+  return buf;
+}
+
+// Contador, callback y waitForVSync().
+void HUB12_1DATA::signalVSync() {
+  _shownSeq.store(_bufSeq[_showBuf], std::memory_order_relaxed);
+  uint32_t n = _vsyncCount.fetch_add(1, std::memory_order_release) + 1;
+  if (_vsyncCb) _vsyncCb(n, _vsyncArg);
+#if defined(ESP32)
+  if (_vsyncWaiting) xSemaphoreGive(_vsyncSem);
+#endif
+}
+
+// Las filas tocadas quedan pendientes en los otros dos buffers; buf ya las tiene.
+void HUB12_1DATA::markStale(uint8_t buf) {
+  uint16_t panels = _panelsX * _panelsY;
+  uint16_t* st0 = _dirtyStale;
+  uint16_t* st1 = st0 + panels;
+  uint16_t* st2 = st1 + panels;
+  for (uint16_t i = 0; i < panels; i++) {
+    uint16_t d = _dirtyRows[i];
+    _dirtyRows[i] = 0;
+    st0[i] |= d; st1[i] |= d; st2[i] |= d;
+  }
+  memset(_dirtyStale + (uint32_t)buf * panels, 0, panels * sizeof(uint16_t));
+}
+
+// ---------- Modo nativo: publicar sin conversión ----------
+void HUB12_1DATA::presentNative() {
+  uint8_t pub = _tbBack;
+  uint8_t* front = _scan[pub];
+  if (!front) return;
+  unsigned long t0 = _statsOn ? micros() : 0;
+
+  // Conteo de LEDs de las filas tocadas, antes de publicar (salvo que
+  // queueFrame()/bakePage() ya lo hayan hecho y no se dibujó nada después)
+  if (_dirty) renderBack();
+  publishScan();
+  uint16_t panelsTotal = _panelsX * _panelsY;
+
+  // El nuevo back quedó atrás: copiar solo las filas que cambiaron desde entonces.
+  uint8_t nb = _tbBack;
+  uint8_t* back = _scan[nb];
+  uint16_t* stale = _dirtyStale + (uint32_t)nb * panelsTotal;
+  _fb = back;
+  for (uint16_t i = 0; i < panelsTotal; i++) {
+    const HUB12PanelMap& pm = _panelMap[i];
+    uint16_t rows = stale[pm.fbPanel];
+    if (!rows) continue;
+
+    for (uint8_t r = 0; r < 4; r++) {
+      uint32_t base = (uint32_t)r * _bytesPerR + (uint32_t)i * 16;
+      if (rows == 0xFFFF) { memcpy(back + base, front + base, 16); continue; }
+      for (uint8_t sub = 0; sub < 4; sub++) {
+        if (!(rows & (1u << ((3 - sub) * 4 + r)))) continue;
+        for (uint8_t j = sub; j < 16; j += 4) back[base + j] = front[base + j];
+      }
+    }
+  }
+  memset(stale, 0, panelsTotal * sizeof(uint16_t));
+  // back == front otra vez: mismos conteos
+  memcpy(litCounts(nb), litCounts(pub), (uint32_t)panelsTotal * 4);
+  memcpy(_litPlane[nb], _litPlane[pub], sizeof(_litPlane[0]));
+  sumLit(nb);
+
+  if (_statsOn) statBuild(micros() - t0);
+}
+
+void HUB12_1DATA::update() {
+  if (_native) {
+    if (_dirty || _needsPublish) presentNative();
+    return;
+  }
+  if (_doubleBuffer) {
+    // Lo dibujado está en _fb (back). Lo hacemos visible intercambiando buffers.
+    swapBuffers(false);  // marca todo dirty
+    buildScan();
+  } else if (_dirty) {
+    buildScan();
+  } else if (_needsPublish) {
+    publishScan();   // back ya armado por queueFrame()/bakePage()
+  }
+}
+
+bool HUB12_1DATA::framePending() const {
+  return (_tbMid.load(std::memory_order_relaxed) & kTbFresh) != 0;
+}
+
+bool HUB12_1DATA::present(uint32_t timeoutMs) {
+  if (!_scan[0]) return false;
+  unsigned long t0 = millis();
+  while (framePending()) {
+    unsigned long waited = millis() - t0;
+    if (waited >= timeoutMs) return false;
+    waitForVSync(timeoutMs - waited);
+  }
+  update();
+  return true;
+}
+
+bool HUB12_1DATA::waitForVSync(uint32_t timeoutMs) {
+  uint32_t c = frameCount();
+  unsigned long t0 = millis();
+#if defined(ESP32)
+  if (_arEnabled && _vsyncSem && xTaskGetCurrentTaskHandle() != _arTask) {
+    // Semáforo propio, no la notificación del task: esa es de la aplicación.
+    // Se descarta un vsync viejo que haya quedado dado.
+    xSemaphoreTake(_vsyncSem, 0);
+    _vsyncWaiting = true;
+    while (frameCount() == c) {
+      unsigned long waited = millis() - t0;
+      if (waited >= timeoutMs) break;
+      xSemaphoreTake(_vsyncSem, pdMS_TO_TICKS(timeoutMs - waited) + 1);
+    }
+    _vsyncWaiting = false;
+    return frameCount() != c;
+  }
+#endif
+  while (frameCount() == c) {
+    if (millis() - t0 >= timeoutMs) return false;
+    yield();
+  }
+  return true;
+}
+
+// ---------- Cola de frames con hora ----------
+bool HUB12_1DATA::setFrameQueue(uint8_t depth) {
+  if (_scan[0]) return false;
+  if (depth > HUB12_FRAME_QUEUE_MAX) return false;
+  _qDepth = depth;
+  return true;
+}
+
+bool HUB12_1DATA::queueFrame(uint32_t atUs) {
+  if (!_qDepth || !_scan[0]) return false;
+  uint32_t tail = _qTail.load(std::memory_order_relaxed);
+  if (tail - _qHead.load(std::memory_order_acquire) >= _qDepth) {
+    _qFull++;
+    return false;
+  }
+  unsigned long t0 = _statsOn ? micros() : 0;
+
+  // Se arma en el back como update() y se copia codificado al lugar de la cola;
+  // el back sigue siendo del productor y queda al día.
+  if (_doubleBuffer && !_native) swapBuffers(false);
+  renderBack();
+  // Lo encolado no está en vivo: el próximo update() tiene que publicar (el back
+  // ya está al día, no reconstruye nada).
+  _needsPublish = true;
+  uint8_t src = _tbBack, dst = (uint8_t)(kTbSlots + tail % _qDepth);
+  memcpy(_scan[dst], _scan[src], _scanBytes * _planes);
+  if (_tx[src]) memcpy(_tx[dst], _tx[src], _scanBytes * _planes);
+  if (_slice[src]) memcpy(_slice[dst], _slice[src], _scanBytes * 8 / _chains * _planes);
+  memcpy(_litRow[dst], _litRow[src], sizeof(_litRow[0]));
+  _litBlank[dst] = _litBlank[src];
+  _bufSeq[dst] = ++_pubSeq;
+  _qDue[tail % _qDepth] = atUs;
+  _qTail.store(tail + 1, std::memory_order_release);
+  _qQueued++;
+
+  if (_statsOn) statBuild(micros() - t0);
+  return true;
+}
+
+uint8_t HUB12_1DATA::queuedFrames() const {
+  return (uint8_t)(_qTail.load(std::memory_order_relaxed) - _qHead.load(std::memory_order_relaxed));
+}
+
+void HUB12_1DATA::clearFrameQueue() {
+  _qFlushTo.store(_qTail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+// Lado refresco, una vez por vsync. _qHead apunta al frame en pantalla mientras
+// _qShowing; se suelta (head + 1) al pasar a otro.
+uint8_t HUB12_1DATA::pickQueued(uint8_t live, bool fresh) {
+  uint32_t head = _qHead.load(std::memory_order_relaxed);
+  uint32_t tail = _qTail.load(std::memory_order_acquire);
+  uint32_t now = micros();
+
+  uint32_t flushTo = _qFlushTo.load(std::memory_order_relaxed);
+  if ((int32_t)(flushTo - head) > 0) {
+    head = flushTo;
+    _qShowing = false;
+  }
+
+  // Vencidos en orden de llegada: se muestra el último, los anteriores se pierden.
+  uint32_t first = _qShowing ? head + 1 : head;
+  uint32_t p = first;
+  while (p != tail && (int32_t)(now - _qDue[p % _qDepth]) >= 0) p++;
+
+  if (p != first) {
+    uint32_t take = p - 1;
+    uint32_t due = _qDue[take % _qDepth];
+    if (take != first) _qDropped.fetch_add(take - first, std::memory_order_relaxed);
+    // Ya vencía en el vsync anterior y no se tomó: no estaba en la cola a tiempo.
+    if ((int32_t)(_qPrevVs - due) >= 0) _qUnderruns.fetch_add(1, std::memory_order_relaxed);
+    uint32_t late = now - due;
+    if (late > _qMaxLate.load(std::memory_order_relaxed)) _qMaxLate.store(late, std::memory_order_relaxed);
+    _qShown.fetch_add(1, std::memory_order_relaxed);
+    head = take;
+    _qShowing = true;
+  } else if (_qShowing && fresh) {
+    // update()/present() publicó algo más nuevo: se vuelve al frame en vivo.
+    head++;
+    _qShowing = false;
+  }
+  _qHead.store(head, std::memory_order_release);
+  _qPrevVs = now;
+  return _qShowing ? (uint8_t)(kTbSlots + head % _qDepth) : live;
+}
+
+HUB12QueueStats HUB12_1DATA::getQueueStats() const {
+  HUB12QueueStats q;
+  q.queued = _qQueued;
+  q.full = _qFull;
+  q.shown = _qShown.load(std::memory_order_relaxed);
+  q.dropped = _qDropped.load(std::memory_order_relaxed);
+  q.underruns = _qUnderruns.load(std::memory_order_relaxed);
+  q.maxLateUs = _qMaxLate.load(std::memory_order_relaxed);
+  return q;
+}
+
+void HUB12_1DATA::resetQueueStats() {
+  _qQueued = 0;
+  _qFull = 0;
+  _qShown.store(0);
+  _qDropped.store(0);
+  _qUnderruns.store(0);
+  _qMaxLate.store(0);
+}
+
+// ---------- Páginas pre-codificadas ----------
+// RLE PackBits: control c < 128 -> c+1 bytes literales; c > 128 -> el byte
+// siguiente repetido 257-c veces. Con out == nullptr solo cuenta el tamaño.
+uint32_t HUB12_1DATA::rleEncode(const uint8_t* src, uint32_t n, uint8_t* out) {
+  uint32_t o = 0, i = 0;
+  while (i < n) {
+    uint32_t run = 1;
+    while (i + run < n && run < 128 && src[i + run] == src[i]) run++;
+    if (run >= 3) {
+      if (out) { out[o] = (uint8_t)(257 - run); out[o + 1] = src[i]; }
+      o += 2;
+      i += run;
+      continue;
+    }
+    // literales hasta la próxima corrida de 3 (o 128 bytes)
+    uint32_t lit = 0;
+    while (i + lit < n && lit < 128) {
+      if (i + lit + 2 < n && src[i + lit] == src[i + lit + 1] && src[i + lit] == src[i + lit + 2]) break;
+      lit++;
+    }
+    if (out) {
+      out[o] = (uint8_t)(lit - 1);
+      memcpy(out + o + 1, src + i, lit);
+    }
+    o += 1 + lit;
+    i += lit;
+  }
+  return o;
+}
+
+void HUB12_1DATA::rleDecode(const uint8_t* src, uint32_t n, uint8_t* out) {
+  uint32_t i = 0;
+  while (i < n) {
+    uint8_t c = src[i++];
+    if (c < 128) {
+      memcpy(out, src + i, c + 1u);
+      out += c + 1u;
+      i += c + 1u;
+    } else if (c > 128) {
+      memset(out, src[i++], 257u - c);
+      out += 257u - c;
+    }
+  }
+}
+
+int HUB12_1DATA::bakePage(bool rle) {
+  if (!_scan[0]) return -1;
+  if (!_pages) {
+    _pages = new (std::nothrow) HUB12Page[HUB12_MAX_PAGES];
+    if (!_pages) return -1;
+  }
+  int slot = -1;
+  for (int i = 0; i < HUB12_MAX_PAGES; i++) if (!_pages[i].data) { slot = i; break; }
+  if (slot < 0) return -1;
+
+  // Se arma en el back como update(), sin publicar (igual que queueFrame()).
+  if (_doubleBuffer && !_native) swapBuffers(false);
+  renderBack();
+  _needsPublish = true;   // la página no es el vivo: el próximo update() publica
+  uint8_t buf = _tbBack;
+  const uint8_t* scan = _scan[buf];
+  uint32_t raw = _scanBytes * _planes;
+
+  HUB12Page& pg = _pages[slot];
+  uint32_t bytes = rle ? rleEncode(scan, raw, nullptr) : raw;
+  if (rle && bytes >= raw) { rle = false; bytes = raw; }   // no comprime: se guarda crudo
+  pg.data = (uint8_t*)malloc(bytes);
+  if (!pg.data) return -1;
+  if (rle) rleEncode(scan, raw, pg.data);
+  else memcpy(pg.data, scan, raw);
+  pg.bytes = bytes;
+  pg.rle = rle;
+  memcpy(pg.litRow, _litRow[buf], sizeof(pg.litRow));
+  pg.litBlank = _litBlank[buf];
+  return slot;
+}
+
+bool HUB12_1DATA::showPage(uint8_t page) {
+  if (!_scan[0] || !_pages || page >= HUB12_MAX_PAGES || !_pages[page].data) return false;
+  const HUB12Page& pg = _pages[page];
+  unsigned long t0 = _statsOn ? micros() : 0;
+  uint8_t buf = _tbBack;
+  uint16_t panels = _panelsX * _panelsY;
+
+  if (pg.rle) rleDecode(pg.data, pg.bytes, _scan[buf]);
+  else memcpy(_scan[buf], pg.data, pg.bytes);
+
+  if (_native) {
+    // Lo dibujado pasa a ser la página: se recuenta y se publica como un update().
+    for (uint16_t i = 0; i < panels; i++) _dirtyRows[i] = 0xFFFF;
+    _dirty = true;
+    presentNative();
+    return true;
+  }
+
+  memcpy(_litRow[buf], pg.litRow, sizeof(pg.litRow));
+  _litBlank[buf] = pg.litBlank;
+  encodeOutput(buf);
+  publishScan();
+  // Ningún scan coincide ya con el framebuffer: el próximo build rehace todo.
+  for (uint32_t i = 0; i < (uint32_t)panels * 3; i++) _dirtyStale[i] = 0xFFFF;
+
+  if (_statsOn) statBuild(micros() - t0);
+  return true;
+}
+
+void HUB12_1DATA::freePage(uint8_t page) {
+  if (!_pages || page >= HUB12_MAX_PAGES || !_pages[page].data) return;
+  free(_pages[page].data);
+  _pages[page] = HUB12Page();
+}
+
+void HUB12_1DATA::freePages() {
+  for (uint8_t i = 0; i < HUB12_MAX_PAGES; i++) freePage(i);
+  delete[] _pages;
+  _pages = nullptr;
+  playlistClear();
+}
+
+uint8_t HUB12_1DATA::pageCount() const {
+  uint8_t n = 0;
+  if (!_pages) return 0;
+  for (uint8_t i = 0; i < HUB12_MAX_PAGES; i++) if (_pages[i].data) n++;
+  return n;
+}
+
+uint32_t HUB12_1DATA::pageBytes(uint8_t page) const {
+  if (!_pages || page >= HUB12_MAX_PAGES || !_pages[page].data) return 0;
+  return _pages[page].bytes;
+}
+
+bool HUB12_1DATA::playlistAdd(uint8_t page, uint16_t ms) {
+  if (_plCount >= HUB12_MAX_PLAYLIST || page >= HUB12_MAX_PAGES) return false;
+  if (!_pl) {
+    _pl = (PlaylistEntry*)calloc(HUB12_MAX_PLAYLIST, sizeof(PlaylistEntry));
+    if (!_pl) return false;
+  }
+  _pl[_plCount].page = page;
+  _pl[_plCount].ms = ms;
+  _plCount++;
+  return true;
+}
+
+void HUB12_1DATA::playlistClear() {
+  free(_pl);
+  _pl = nullptr;
+  _plCount = 0;
+  _plPos = 0;
+  _plStarted = false;
+}
+
+bool HUB12_1DATA::playlistUpdate() {
+  if (!_plCount) return false;
+  unsigned long now = millis();
+  if (!_plStarted) {
+    _plStarted = true;
+    _plPos = 0;
+    _plLast = now;
+    return showPage(_pl[0].page);
+  }
+  if (now - _plLast < _pl[_plPos].ms) return false;
+  // Sin deriva: la próxima cuenta desde la hora prevista, salvo que vaya muy atrasado.
+  _plLast += _pl[_plPos].ms;
+  _plPos = (uint8_t)((_plPos + 1) % _plCount);
+  if (now - _plLast >= _pl[_plPos].ms) _plLast = now;
+  return showPage(_pl[_plPos].page);
+}
+
+// ---------- Salida SPI+DMA ----------
+void HUB12_1DATA::encodeSpiStream(const uint8_t* scan, uint8_t* out, uint32_t bytes) {
+  // El scan ya está en orden de shift y MSB-first (igual que SPI modo 0);
+  // solo falta invertir porque DATA es activo LOW. Los buffers son múltiplo de 16.
+  const uint32_t* s = (const uint32_t*)scan;
+  uint32_t* d = (uint32_t*)out;
+  for (uint32_t i = 0; i < (bytes >> 2); i++) d[i] = ~s[i];
+}
+
+// Multi-cadena: en cada flanco de CLK, bit c = pixel de la cadena c.
+// Un byte del scan (8 flancos) se reparte en 8 bytes de salida con un
+// broadcast + máscara: byte j del resultado = bit (7-j) de v (MSB primero).
+static inline uint64_t spreadBits(uint8_t v) {
+  uint64_t x = (uint64_t)v * 0x0101010101010101ULL;
+  x &= 0x0102040810204080ULL;
+  x += 0x7F7E7C7870604000ULL;
+  return (x & 0x8080808080808080ULL) >> 7;
+}
+
+void HUB12_1DATA::encodeSlices(const uint8_t* scan, uint8_t* out) const {
+  uint32_t bpc = _bytesPerR / _chains;   // bytes por cadena y fila
+
+  for (uint8_t r = 0; r < 4; r++) {
+    const uint8_t* row = scan + (uint32_t)r * _bytesPerR;
+    for (uint32_t k = 0; k < bpc; k++) {
+      uint64_t acc = 0;
+      for (uint8_t c = 0; c < _chains; c++) acc |= spreadBits(row[c * bpc + k]) << c;
+      memcpy(out, &acc, 8);   // little-endian: byte j = flanco j
+      out += 8;
+    }
+  }
+}
+
+// Deja listo el stream del scan que se va a publicar (mismo índice del triple buffer).
+void HUB12_1DATA::encodeOutput(uint8_t buf) {
+  const uint8_t* scan = _scan[buf];
+  if (_spiOut && _tx[buf]) encodeSpiStream(scan, _tx[buf], _scanBytes * _planes);
+  if (_chains > 1 && _slice[buf]) {
+    uint32_t sliceBytes = _scanBytes * 8 / _chains;
+    for (uint8_t k = 0; k < _planes; k++)
+      encodeSlices(scan + (uint32_t)k * _scanBytes, _slice[buf] + k * sliceBytes);
+  }
+}
+
+#if defined(ESP32)
+bool HUB12_1DATA::spiBegin() {
+  spi_bus_config_t bus = {};
+  bus.mosi_io_num = _p.data;
+  bus.miso_io_num = -1;
+  bus.sclk_io_num = _p.clk;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = _bytesPerR;
+
+  if (spi_bus_initialize(HUB12_SPI_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK) return false;
+
+  spi_device_interface_config_t dev = {};
+  dev.mode = 0;                 // CLK idle LOW, DATA se toma en el flanco de subida
+  dev.clock_speed_hz = (int)_spiHz;
+  dev.spics_io_num = -1;
+  dev.queue_size = 1;
+
+  if (spi_bus_add_device(HUB12_SPI_HOST, &dev, &_spi) != ESP_OK) {
+    _spi = nullptr;
+    spi_bus_free(HUB12_SPI_HOST);
+    return false;
+  }
+  return true;
+}
+
+void HUB12_1DATA::spiEnd() {
+  if (!_spi) return;
+  spi_bus_remove_device(_spi);
+  spi_bus_free(HUB12_SPI_HOST);
+  _spi = nullptr;
+}
+#else
+bool HUB12_1DATA::spiBegin() { return false; }
+void HUB12_1DATA::spiEnd() {}
+#endif
+
+// ---------- Refresh (muy rápido) ----------
+// Carga y muestra UNA fila r: OE apagado, shift, latch, OE encendido. No espera.
+// plane elige el juego de filas en escala de grises.
+void HUB12_1DATA::shiftRow(uint8_t buf, uint8_t r, uint8_t plane) {
+  fastLow(_fOE);     // apagar mientras carga
+  setRow(r);
+
+#if defined(ESP32)
+  if (_spi) {
+    // El DMA saca la fila ya codificada; el task queda bloqueado (no ocupa CPU).
+    spi_transaction_t t = {};
+    t.length = _bytesPerR * 8;   // en bits
+    t.tx_buffer = _tx[buf] + (uint32_t)plane * _scanBytes + (uint32_t)r * _bytesPerR;
+    spi_device_transmit(_spi, &t);
+
+    pulseLAT();
+    fastHigh(_fOE);  // mostrar
+    return;
+  }
+#endif
+
+  if (_chains > 1) {
+    // Una escritura por polaridad mueve los DATA de todas las cadenas a la vez.
+    uint32_t steps = _bytesPerR * 8 / _chains;
+    const uint8_t* sl = _slice[buf] + (uint32_t)(plane * 4 + r) * steps;
+
+    for (uint32_t i = 0; i < steps; i++) {
+      uint32_t on = _sliceLut[sl[i]];   // DATA activo LOW
+      gpioClr(_dataHiBank, on);
+      gpioSet(_dataHiBank, _dataMask & ~on);
+      pulseCLK();
+    }
+
+    pulseLAT();
+    fastHigh(_fOE);  // mostrar
+    return;
+  }
+
+  const uint8_t* rowStream = _scan[buf] + (uint32_t)plane * _scanBytes + (uint32_t)r * _bytesPerR;
+
+  for (uint32_t i = 0; i < _bytesPerR; i++) {
+    uint8_t v = rowStream[i];
+    for (int b = 7; b >= 0; b--) {
+      writeData((v >> b) & 1);
+      pulseCLK();
+    }
+  }
+
+  pulseLAT();
+  fastHigh(_fOE);    // mostrar
+}
+
+void HUB12_1DATA::refresh() {
+  unsigned long t0 = _statsOn ? micros() : 0;
+  if (!_scan[0]) return;
+  uint8_t buf = beginCycle();   // nunca construye: muestra el último frame publicado
+
+  // Cada fila conserva su ranura aunque esté vacía o limitada (OE apagado el
+  // resto): el brillo de las demás no depende del contenido.
+  uint16_t blank = _litBlank[buf];
+  for (uint8_t r = 0; r < 4; r++) {
+    for (uint8_t k = 0; k < _planes; k++) {
+      uint32_t slot = planeOnUs(_onTimeUs, k);
+      if (blank & (1u << (r * 4 + k))) {   // vacía: sin shift
+        fastLow(_fOE);
+        delayMicroseconds(slot);
+        continue;
+      }
+      shiftRow(buf, r, k);
+      uint32_t on = rowOnUs(buf, r, slot);
+      delayMicroseconds(on);
+      if (on < slot) {
+        fastLow(_fOE);
+        delayMicroseconds(slot - on);
+      }
+    }
+  }
+  _rowNext = 0;
+  _planeNext = 0;
+  if (_statsOn) statRefresh(micros() - t0);
+}
+
+uint8_t HUB12_1DATA::refreshRow() {
+  unsigned long t0 = _statsOn ? micros() : 0;
+  uint8_t r = _rowNext, k = _planeNext;
+  if (!_scan[0]) return 0;
+  // Solo al inicio del ciclo de 4 filas se toma un frame nuevo: un ciclo no mezcla frames.
+  uint8_t buf = (r == 0 && k == 0) ? beginCycle() : _showBuf;
+
+  if (_litBlank[buf] & (1u << (r * 4 + k))) {
+    fastLow(_fOE);   // fila vacía: sin shift, OE apagado
+    _rowOnUs = 0;
   } else {
-    panelIdx = py * _panelsX + (_panelsX - 1 - px);
-    lx = 31 - lx; // invierte X local para mantener coordenadas globales rectas
+    shiftRow(buf, r, k);
+    _rowOnUs = rowOnUs(buf, r, planeOnUs(_onTimeUs, k));
+  }
+  if (k + 1 < _planes) {
+    _planeNext = k + 1;
+  } else {
+    _planeNext = 0;
+    _rowNext = (r + 1) & 3;
   }
+  if (_statsOn) statRefresh(micros() - t0);
+  return (uint8_t)(1u << k);
 }
 
-// ---------- Scan build (rápido) ----------
-void HUB12_1DATA::buildScan() {
-  // Construye en el buffer "back" y luego hace swap atomico.
-  if (!_scanActive || !_scanA || !_scanB) return;
-
-  uint8_t* out = (uint8_t*)((_scanActive == _scanA) ? _scanB : _scanA);
-  memset(out, 0, _scanBytes);
-
-  for (int gy = 0; gy < (int)_h; gy++) {
-    for (int gx = 0; gx < (int)_w; gx++) {
-      if (!fbGet(gx, gy)) continue;
+// BCM: el plano k ocupa 2^k de las (2^bits - 1) unidades de us. En monocromo, us.
+uint32_t HUB12_1DATA::planeOnUs(uint32_t us, uint8_t plane) const {
+  if (_planes == 1) return us;
+  return (us << plane) / maxLevel();
+}
 
-      uint8_t panelIdx;
-      int lx, ly;
-      mapGlobalToChain(gx, gy, panelIdx, lx, ly);
+// ---------- Estadísticas ----------
+// Sin locks: cada contador tiene un solo escritor (task de refresco o loop), así
+// que una lectura concurrente puede mezclar dos muestras pero nunca corrompe nada.
+static const uint16_t kJitterUs[HUB12_JITTER_BINS - 1] = { 2, 5, 10, 20, 50, 100, 200 };
 
-      uint8_t r = (uint8_t)(ly & 3);
+void HUB12_1DATA::statRefresh(uint32_t us) {
+  _stats.refreshes++;
+  _stats.refreshTotalUs += us;
+  if (us < _statRefreshMin) _statRefreshMin = us;
+  if (us > _stats.refreshMaxUs) _stats.refreshMaxUs = us;
+}
 
-      int bit = xyToBitIndexLocal(lx, ly);       // 0..127
-      uint32_t byteInPanel = (uint32_t)bit >> 3; // 0..15
-      uint8_t bitInByte = 7 - (bit & 7);         // MSB-first
+void HUB12_1DATA::statBuild(uint32_t us) {
+  _stats.builds++;
+  _stats.buildTotalUs += us;
+  if (us < _statBuildMin) _statBuildMin = us;
+  if (us > _stats.buildMaxUs) _stats.buildMaxUs = us;
+}
 
-      uint32_t base = (uint32_t)r * _bytesPerR + (uint32_t)panelIdx * 16;
-      out[base + byteInPanel] |= (1 << bitInByte);
-    }
-  }
+void HUB12_1DATA::statLock(uint32_t cycles) {
+  _stats.scanLocks++;
+  _stats.scanLockTotalCycles += cycles;
+  if (cycles > _stats.scanLockMaxCycles) _stats.scanLockMaxCycles = cycles;
+}
 
 #if defined(ESP32)
-  portENTER_CRITICAL(&_scanMux);
-  _scanActive = out;
-  portEXIT_CRITICAL(&_scanMux);
-#else
-  _scanActive = out;
+// notified = valor de ulTaskNotifyTake: ticks acumulados desde el último despertar.
+void HUB12_1DATA::statWake(uint32_t notified) {
+  unsigned long now = micros();
+  _stats.ticks++;
+  if (notified > 1) _stats.missedTicks += notified - 1;
+
+  if (_statLastWake) {
+    int32_t dev = (int32_t)(now - _statLastWake) - (int32_t)(notified * (_arPeriodUs / 4u));
+    uint32_t a = (dev < 0) ? (uint32_t)-dev : (uint32_t)dev;
+    uint8_t bin = 0;
+    while (bin < HUB12_JITTER_BINS - 1 && a >= kJitterUs[bin]) bin++;
+    _stats.jitter[bin]++;
+  }
+  _statLastWake = now;
+}
 #endif
 
-  _dirty = false;
+HUB12Stats HUB12_1DATA::getStats() const {
+  HUB12Stats s = _stats;
+  s.refreshMinUs = s.refreshes ? _statRefreshMin : 0;
+  s.refreshAvgUs = s.refreshes ? (uint32_t)(s.refreshTotalUs / s.refreshes) : 0;
+  s.buildMinUs = s.builds ? _statBuildMin : 0;
+  s.buildAvgUs = s.builds ? (uint32_t)(s.buildTotalUs / s.builds) : 0;
+  return s;
 }
 
-void HUB12_1DATA::update() {
-  if (_doubleBuffer) {
-    // Lo dibujado está en _fb (back). Lo hacemos visible intercambiando buffers.
-    swapBuffers(false);
-    _dirty = true;
-    buildScan();
-  } else {
-    if (_dirty) buildScan();
-  }
+void HUB12_1DATA::resetStats() {
+  _stats = HUB12Stats();
+  _statRefreshMin = UINT32_MAX;
+  _statBuildMin = UINT32_MAX;
+  _statLastWake = 0;
 }
 
-// ---------- Refresh (muy rápido) ----------
-void HUB12_1DATA::refresh() {
-  if (_dirty) buildScan();
-
-  const uint8_t* scan;
+void HUB12_1DATA::setOnTimeUs(uint16_t us) {
+  _onTimeUs = us;
 #if defined(ESP32)
-  portENTER_CRITICAL(&_scanMux);
-  scan = (const uint8_t*)_scanActive;
-  portEXIT_CRITICAL(&_scanMux);
-#else
-  scan = (const uint8_t*)_scanActive;
+  arRetime();
 #endif
-  if (!scan) return;
-
-  for (uint8_t r = 0; r < 4; r++) {
-    fastLow(_fOE);     // apagar mientras carga
-    setRow(r);
-
-    const uint8_t* rowStream = scan + (uint32_t)r * _bytesPerR;
-
-    for (uint32_t i = 0; i < _bytesPerR; i++) {
-      uint8_t v = rowStream[i];
-      for (int b = 7; b >= 0; b--) {
-        writeData((v >> b) & 1);
-        pulseCLK();
-      }
-    }
+}
 
-    pulseLAT();
-    fastHigh(_fOE);    // mostrar
-    delayMicroseconds(_onTimeUs);
-  }
+void HUB12_1DATA::setPowerBudget(uint32_t leds, uint16_t maxOnUs) {
+  _powerLeds = leds;
+  _powerMaxUs = maxOnUs;
+#if defined(ESP32)
+  arRetime();
+#endif
 }
 
 void HUB12_1DATA::drawCircle(int x0, int y0, int r, bool on) {
@@ -505,51 +1889,169 @@ void HUB12_1DATA::fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, b
   _dirty = true;
 }
 
-void HUB12_1DATA::setFont(const uint8_t* font) {
-  _font = font;
-}
+#if defined(ARDUINO)
+  #include <pgmspace.h>  // asegúrate que esté arriba del archivo
+#endif
 
-#include <pgmspace.h>  // asegúrate que esté arriba del archivo
+// ---------- Fuente: header cacheado + índice de glifos ----------
+// Header DMD2: size(2) w h first count, luego (si size != 0) count anchos y los datos.
+uint8_t HUB12_1DATA::buildGlyphIndex(const uint8_t* font, HUB12Glyph* out) {
+  if (!font || !out) return 0;
+  uint16_t size = (uint16_t)pgm_read_byte(font + 0) | ((uint16_t)pgm_read_byte(font + 1) << 8);
+  if (size == 0) return 0;
+
+  uint8_t bytesPerCol = (pgm_read_byte(font + 3) + 7) >> 3;
+  uint8_t count = pgm_read_byte(font + 5);
+  const uint8_t* widths = font + 6;
+
+  uint32_t ofs = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t w = pgm_read_byte(widths + i);
+    out[i].ofs = (uint16_t)ofs;
+    out[i].w = w;
+    ofs += (uint32_t)w * bytesPerCol;
+  }
+  return count;
+}
 
-void HUB12_1DATA::drawChar(int x, int y, char c, bool on) {
-  if (!_font) return;
+void HUB12_1DATA::setFont(const uint8_t* font, const HUB12Glyph* glyphs, const uint8_t* atlas) {
+  if (_glyphsOwn) { free(_glyphsOwn); _glyphsOwn = nullptr; }
+  if (_atlasOwn)  { free(_atlasOwn);  _atlasOwn = nullptr; }
+  _glyphs = nullptr;
+  _atlas = nullptr;
+  _font = font;
+  _fontData = nullptr;
+  if (!font) return;
+
+  uint16_t size = (uint16_t)pgm_read_byte(font + 0) | ((uint16_t)pgm_read_byte(font + 1) << 8);
+  _fontW = pgm_read_byte(font + 2);
+  _fontH = pgm_read_byte(font + 3);
+  _fontFirst = pgm_read_byte(font + 4);
+  _fontCount = pgm_read_byte(font + 5);
+  _fontBytesPerCol = (_fontH + 7) >> 3;
+  _fontVar = (size != 0);
+  _fontData = font + 6 + (_fontVar ? _fontCount : 0);
+
+  if (_fontVar) {
+    if (glyphs) {
+      _glyphs = glyphs;
+    } else {
+      _glyphsOwn = (HUB12Glyph*)calloc(_fontCount ? _fontCount : 1, sizeof(HUB12Glyph));
+      if (!_glyphsOwn) { _font = nullptr; return; }   // sin RAM: sin fuente
+      buildGlyphIndex(font, _glyphsOwn);
+      _glyphs = _glyphsOwn;
+    }
+  }
 
-  uint16_t size = (uint16_t)pgm_read_byte(_font + 0) |
-                  ((uint16_t)pgm_read_byte(_font + 1) << 8);
+  _atlasStride = glyphAtlasStride(font);
+  if (atlas && _atlasStride) _atlas = atlas;
+  else if (_atlasOn) setGlyphAtlas(true);
+}
 
-  uint8_t fontW   = pgm_read_byte(_font + 2);
-  uint8_t fontH   = pgm_read_byte(_font + 3);
-  uint8_t first   = pgm_read_byte(_font + 4);
-  uint8_t count   = pgm_read_byte(_font + 5);
+// ---------- Atlas de glifos (filas de bits) ----------
+// Bytes por fila del atlas: ceil(ancho máximo / 8); 0 si algún glifo pasa de 32 px.
+uint8_t HUB12_1DATA::glyphAtlasStride(const uint8_t* font) {
+  uint16_t size = (uint16_t)pgm_read_byte(font + 0) | ((uint16_t)pgm_read_byte(font + 1) << 8);
+  uint8_t maxW = pgm_read_byte(font + 2);
+  if (size != 0) {
+    uint8_t count = pgm_read_byte(font + 5);
+    maxW = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      uint8_t w = pgm_read_byte(font + 6 + i);
+      if (w > maxW) maxW = w;
+    }
+  }
+  if (maxW == 0 || maxW > 32) return 0;
+  return (maxW + 7) >> 3;
+}
 
-  uint8_t uc = (uint8_t)c;
-  if (uc < first || uc >= (uint8_t)(first + count)) return;
+uint32_t HUB12_1DATA::buildGlyphAtlas(const uint8_t* font, uint8_t* out) {
+  if (!font) return 0;
+  uint8_t stride = glyphAtlasStride(font);
+  if (!stride) return 0;
 
-  uint8_t idx = uc - first;
+  uint16_t size = (uint16_t)pgm_read_byte(font + 0) | ((uint16_t)pgm_read_byte(font + 1) << 8);
+  uint8_t fontW = pgm_read_byte(font + 2);
+  uint8_t fontH = pgm_read_byte(font + 3);
+  uint8_t count = pgm_read_byte(font + 5);
+  uint32_t bytes = (uint32_t)count * fontH * stride;
+  if (!out) return bytes;
 
   uint8_t bytesPerCol = (fontH + 7) >> 3;
+  const uint8_t* data = font + 6 + (size ? count : 0);
+  memset(out, 0, bytes);
+
+  uint32_t ofs = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    uint8_t w = size ? pgm_read_byte(font + 6 + i) : fontW;
+    uint8_t* g = out + (uint32_t)i * fontH * stride;
+
+    // Mismo layout que drawChar(): por bloques de 8 filas, una columna por byte.
+    for (uint8_t col = 0; col < w; col++) {
+      for (uint8_t row = 0; row < fontH; row++) {
+        uint8_t b = pgm_read_byte(data + ofs + col + (uint32_t)(row >> 3) * w);
+        if (b & (1 << (row & 7))) g[row * stride + (col >> 3)] |= (uint8_t)(1 << (col & 7));
+      }
+    }
+    ofs += (uint32_t)w * bytesPerCol;
+  }
+  return bytes;
+}
 
-  const uint8_t* widths = _font + 6;
-  const uint8_t* data;
+bool HUB12_1DATA::setGlyphAtlas(bool enable) {
+  _atlasOn = enable;
+  if (_atlasOwn) { free(_atlasOwn); _atlasOwn = nullptr; }
+  _atlas = nullptr;
+  if (!enable || !_font) return true;   // sin fuente: se arma en setFont()
+
+  uint32_t bytes = buildGlyphAtlas(_font, nullptr);
+  if (!bytes) return false;
+  _atlasOwn = (uint8_t*)malloc(bytes);
+  if (!_atlasOwn) return false;
+  buildGlyphAtlas(_font, _atlasOwn);
+  _atlas = _atlasOwn;
+  return true;
+}
 
-  uint8_t charW = fontW;
-  uint32_t offset = 0;
+// Offset (desde _fontData) y ancho del glifo; false si el carácter no está en la fuente.
+inline bool HUB12_1DATA::glyph(uint8_t uc, uint32_t& ofs, uint8_t& w) const {
+  uint8_t idx = (uint8_t)(uc - _fontFirst);
+  if (uc < _fontFirst || idx >= _fontCount) return false;
 
-  if (size == 0) {
-    // ANCHO FIJO (System5x7): data empieza en +6
-    data = _font + 6;
-    charW = fontW;
-    offset = (uint32_t)idx * (uint32_t)charW * bytesPerCol;
+  if (_fontVar) {
+    ofs = _glyphs[idx].ofs;
+    w = _glyphs[idx].w;
   } else {
-    // ANCHO VARIABLE (Arial_Black_16): widths[0..count-1], data empieza después
-    data = widths + count;
-    charW = pgm_read_byte(widths + idx);
+    ofs = (uint32_t)idx * _fontW * _fontBytesPerCol;
+    w = _fontW;
+  }
+  return true;
+}
 
-    for (uint8_t i = 0; i < idx; i++) {
-      offset += (uint32_t)pgm_read_byte(widths + i) * bytesPerCol;
-    }
+// Avance horizontal: ancho fijo, o el del glifo (ancho fijo si no está en la fuente).
+inline uint8_t HUB12_1DATA::glyphAdvance(uint8_t uc) const {
+  uint8_t idx = (uint8_t)(uc - _fontFirst);
+  if (!_fontVar || uc < _fontFirst || idx >= _fontCount) return _fontW;
+  return _glyphs[idx].w;
+}
+
+void HUB12_1DATA::drawChar(int x, int y, char c, bool on) {
+  if (!_font) return;
+
+  uint32_t offset;
+  uint8_t charW;
+  if (!glyph((uint8_t)c, offset, charW)) return;
+
+  if (_atlas) {
+    const uint8_t* rows = _atlas + (uint32_t)((uint8_t)c - _fontFirst) * _fontH * _atlasStride;
+    blit(x, y, rows, charW, _fontH, on ? ROP_OR : ROP_ANDNOT, _atlasStride, true);
+    return;
   }
 
+  const uint8_t* data = _fontData;
+  uint8_t fontH = _fontH;
+  uint8_t bytesPerCol = _fontBytesPerCol;
+
   // Dibujo: en FontCreator los bytes no vienen intercalados por columna cuando fontH>8:
   // primero todas las columnas LOW, luego todas las columnas HIGH (por bloques de charW).
   for (uint8_t col = 0; col < charW; col++) {
@@ -580,27 +2082,10 @@ void HUB12_1DATA::drawChar(int x, int y, char c, bool on) {
 void HUB12_1DATA::drawText(int x, int y, const char* s, bool on, uint8_t spacing) {
   if (!_font) return;
 
-  uint16_t size = (uint16_t)pgm_read_byte(_font + 0) |
-                  ((uint16_t)pgm_read_byte(_font + 1) << 8);
-
-  uint8_t fontW = pgm_read_byte(_font + 2);
-  uint8_t first = pgm_read_byte(_font + 4);
-  uint8_t count = pgm_read_byte(_font + 5);
-
-  const uint8_t* widths = _font + 6;
-
   int cx = x;
   while (*s) {
     char c = *s++;
-    uint8_t uc = (uint8_t)c;
-
-    uint8_t adv = fontW; // default
-
-    if (size != 0) {
-      if (uc >= first && uc < (uint8_t)(first + count)) {
-        adv = pgm_read_byte(widths + (uc - first));
-      }
-    }
+    uint8_t adv = glyphAdvance((uint8_t)c);
 
     drawChar(cx, y, c, on);
     cx += (int)adv + (int)spacing;
@@ -611,70 +2096,110 @@ void HUB12_1DATA::drawText(int x, int y, const char* s, bool on, uint8_t spacing
 int HUB12_1DATA::textWidth(const char* s, uint8_t spacing) {
   if (!_font || !s) return 0;
 
-  uint16_t size = (uint16_t)pgm_read_byte(_font + 0) |
-                  ((uint16_t)pgm_read_byte(_font + 1) << 8);
-
-  uint8_t fontW = pgm_read_byte(_font + 2);
-  uint8_t first = pgm_read_byte(_font + 4);
-  uint8_t count = pgm_read_byte(_font + 5);
-
-  const uint8_t* widths = _font + 6;
-
   int w = 0;
   while (*s) {
-    uint8_t uc = (uint8_t)(*s++);
-    uint8_t adv = fontW; // fijo por defecto
-
-    if (size != 0) { // fuente variable
-      if (uc >= first && uc < (uint8_t)(first + count)) {
-        adv = pgm_read_byte(widths + (uc - first));
-      }
-    }
-
-    w += adv;
+    w += glyphAdvance((uint8_t)(*s++));
     if (*s) w += spacing; // no agregar espacio extra al final
   }
   return w;
 }
-void HUB12_1DATA::drawCharScaled(int x, int y, char c, uint8_t scale, bool on) {
-  if (!_font) return;
-  if (scale < 1) scale = 1;
-
-  uint16_t size = (uint16_t)pgm_read_byte(_font + 0) |
-                  ((uint16_t)pgm_read_byte(_font + 1) << 8);
-
-  uint8_t fontW   = pgm_read_byte(_font + 2);
-  uint8_t fontH   = pgm_read_byte(_font + 3);
-  uint8_t first   = pgm_read_byte(_font + 4);
-  uint8_t count   = pgm_read_byte(_font + 5);
-
-  uint8_t uc = (uint8_t)c;
-  if (uc < first || uc >= (uint8_t)(first + count)) return;
-
-  uint8_t idx = uc - first;
-  uint8_t bytesPerCol = (fontH + 7) >> 3;
+// ---------- Texto escalado ----------
+// Cada nibble de la fila -> 4 bits repetidos 2, 3 o 4 veces
+static const uint8_t  kExpand2[16] = { 0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+                                       0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF };
+static const uint16_t kExpand3[16] = { 0x000, 0x007, 0x038, 0x03F, 0x1C0, 0x1C7, 0x1F8, 0x1FF,
+                                       0xE00, 0xE07, 0xE38, 0xE3F, 0xFC0, 0xFC7, 0xFF8, 0xFFF };
+static const uint16_t kExpand4[16] = { 0x0000, 0x000F, 0x00F0, 0x00FF, 0x0F00, 0x0F0F, 0x0FF0, 0x0FFF,
+                                       0xF000, 0xF00F, 0xF0F0, 0xF0FF, 0xFF00, 0xFF0F, 0xFFF0, 0xFFFF };
+
+// Repite cada uno de los n bits de 'bits' scale veces (1..8) en out, LSB primero.
+static void expandBits(uint32_t bits, uint8_t n, uint8_t scale, uint8_t* out) {
+  uint64_t acc = 0;
+  uint8_t accN = 0;
+
+  for (uint8_t i = 0; i < n; i += 4) {
+    uint8_t nib = (bits >> i) & 0x0F;   // los bits por encima de n ya son 0
+    uint32_t e;
+    switch (scale) {
+      case 1: e = nib; break;
+      case 2: e = kExpand2[nib]; break;
+      case 3: e = kExpand3[nib]; break;
+      case 4: e = kExpand4[nib]; break;
+      default:
+        e = 0;
+        for (uint8_t k = 0; k < 4; k++)
+          if (nib & (1 << k)) e |= ((1u << scale) - 1) << (k * scale);
+        break;
+    }
+    acc |= (uint64_t)e << accN;
+    accN += 4 * scale;
+    while (accN >= 8) { *out++ = (uint8_t)acc; acc >>= 8; accN -= 8; }
+  }
+  if (accN) *out = (uint8_t)acc;
+}
 
-  const uint8_t* widths = _font + 6;
-  const uint8_t* data;
+// Fila 'row' del glifo como bits (bit 0 = columna izquierda), del atlas o de la fuente.
+uint32_t HUB12_1DATA::glyphRow(uint8_t idx, uint32_t ofs, uint8_t w, uint8_t row) const {
+  uint32_t bits = 0;
+  if (_atlas) {
+    const uint8_t* p = _atlas + ((uint32_t)idx * _fontH + row) * _atlasStride;
+    for (uint8_t k = 0; k < _atlasStride; k++) bits |= (uint32_t)pgm_read_byte(p + k) << (8 * k);
+    return bits;
+  }
 
-  uint8_t charW = fontW;
-  uint32_t offset = 0;
+  const uint8_t* p = _fontData + ofs + (uint32_t)(row >> 3) * w;
+  uint8_t m = (uint8_t)(1 << (row & 7));
+  for (uint8_t col = 0; col < w; col++)
+    if (pgm_read_byte(p + col) & m) bits |= 1u << col;
+  return bits;
+}
 
-  if (size == 0) {
-    // ancho fijo (System5x7)
-    data = _font + 6;
-    charW = fontW;
-    offset = (uint32_t)idx * (uint32_t)charW * bytesPerCol;
-  } else {
-    // ancho variable (Arial_Black_16)
-    data = widths + count;
-    charW = pgm_read_byte(widths + idx);
+void HUB12_1DATA::drawCharScaled(int x, int y, char c, uint8_t scale, bool on) {
+  if (!_font) return;
+  if (scale < 1) scale = 1;
 
-    for (uint8_t i = 0; i < idx; i++) {
-      offset += (uint32_t)pgm_read_byte(widths + i) * bytesPerCol;
+  uint32_t offset;
+  uint8_t charW;
+  if (!glyph((uint8_t)c, offset, charW)) return;
+
+  uint8_t idx = (uint8_t)((uint8_t)c - _fontFirst);
+
+  // Como con fillRect() por pixel: recorta a pantalla pero no a setClipRect().
+  // Cada fila del glifo se expande una vez y se escribe en sus 'scale' filas.
+  if (charW <= 32 && scale <= 8 && _fb) {
+    int ew = (int)charW * scale;
+    int x0 = x, y0 = y, x1 = x + ew - 1, y1 = y + (int)_fontH * scale - 1;
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= (int)_w) x1 = _w - 1;
+    if (y1 >= (int)_h) y1 = _h - 1;
+    if (x0 > x1 || y0 > y1) return;
+
+    uint8_t line[32];                 // fila expandida: hasta 32 px * 8, LSB primero
+    uint32_t* fb = (uint32_t*)_fb;
+    uint32_t wpr = _w >> 5;
+    for (uint8_t row = 0; row < _fontH; row++) {
+      int ry = y + (int)row * scale;
+      int ra = (ry > y0) ? ry : y0;
+      int rb = (ry + scale - 1 < y1) ? ry + scale - 1 : y1;
+      if (ra > rb) continue;
+
+      uint32_t bits = glyphRow(idx, offset, charW, row);
+      if (!bits) continue;
+      expandBits(bits, charW, scale, line);
+
+      if (_native || _planes > 1) blitRaw(x, ry, line, ew, scale, on ? ROP_OR : ROP_ANDNOT, 0, true, false);
+      else if (on) blitRows<ROP_OR, true>(fb, wpr, x, ry, x0, ra, x1, rb, line, 0);
+      else         blitRows<ROP_ANDNOT, true>(fb, wpr, x, ry, x0, ra, x1, rb, line, 0);
     }
+    markDirty(x0, y0, x1, y1);
+    return;
   }
 
+  const uint8_t* data = _fontData;
+  uint8_t fontH = _fontH;
+  uint8_t bytesPerCol = _fontBytesPerCol;
+
   // Dibujo escalado (respeta el “layout” FontCreator para H>8)
   for (uint8_t col = 0; col < charW; col++) {
     for (uint8_t row = 0; row < fontH; row++) {
@@ -705,25 +2230,10 @@ void HUB12_1DATA::drawTextScaled(int x, int y, const char* s, uint8_t scale, boo
   if (!_font || !s) return;
   if (scale < 1) scale = 1;
 
-  uint16_t size = (uint16_t)pgm_read_byte(_font + 0) |
-                  ((uint16_t)pgm_read_byte(_font + 1) << 8);
-
-  uint8_t fontW = pgm_read_byte(_font + 2);
-  uint8_t first = pgm_read_byte(_font + 4);
-  uint8_t count = pgm_read_byte(_font + 5);
-  const uint8_t* widths = _font + 6;
-
   int cx = x;
   while (*s) {
     char c = *s++;
-    uint8_t uc = (uint8_t)c;
-
-    uint8_t adv = fontW; // avance base
-    if (size != 0) {     // variable
-      if (uc >= first && uc < (uint8_t)(first + count)) {
-        adv = pgm_read_byte(widths + (uc - first));
-      }
-    }
+    uint8_t adv = glyphAdvance((uint8_t)c);   // avance base
 
     drawCharScaled(cx, y, c, scale, on);
     cx += (int)(adv + spacing) * (int)scale;
@@ -742,7 +2252,7 @@ void HUB12_1DATA::drawTextScaledCentered(const char* s, uint8_t scale, bool on,
   if (scale < 1) scale = 1;
   if (!_font) return;
 
-  uint8_t fontH = pgm_read_byte(_font + 3);
+  uint8_t fontH = _fontH;
 
   int tw = textWidthScaled(s, scale, spacing);
   int th = (int)fontH * (int)scale;
@@ -779,67 +2289,515 @@ void HUB12_1DATA::clearClipRect() {
 }
 uint8_t HUB12_1DATA::fontHeight() const {
   if (!_font) return 0;
-  return pgm_read_byte(_font + 3);
+  return _fontH;
 }
 
 uint8_t HUB12_1DATA::fontWidth() const {
   if (!_font) return 0;
-  return pgm_read_byte(_font + 2);
+  return _fontW;
 }
 void HUB12_1DATA::marqueeStart(int x, int y, int w, int h, const char* text, uint8_t spacing, uint16_t stepMs) {
-  _mqEnabled = false;
-  _mqText = text;
-  if (!_mqText || !_font) return;
-  if (w <= 0 || h <= 0) return;
+  _mq.stop();
+  if (!_font) return;
+  _mq.start(x, y, w, h, text, spacing, stepMs);
+}
+
+void HUB12_1DATA::marqueeTick(bool on) {
+  if (!_font) return;
+  _mq.tick(on);
+}
 
-  // recorta a pantalla
-  if (x < 0) { w += x; x = 0; }
-  if (y < 0) { h += y; y = 0; }
-  if (x + w > (int)width())  w = width()  - x;
-  if (y + h > (int)height()) h = height() - y;
-  if (w <= 0 || h <= 0) return;
+void HUB12_1DATA::marqueeStop() {
+  _mq.stop();
+}
 
-  _mqX0 = x; _mqY0 = y; _mqW = w; _mqH = h;
-  _mqSpacing = spacing;
-  _mqStepMs = stepMs;
+// ---------- Gestor de marquesinas ----------
+int HUB12_1DATA::marqueeAdd(int x, int y, int w, int h, const char* text, uint8_t spacing,
+                            uint16_t stepMs, MarqueeDir dir) {
+  if (!_font) return -1;
+  if (!_mqs) {
+    _mqs = new (std::nothrow) Marquee[HUB12_MAX_MARQUEES];
+    if (!_mqs) return -1;
+    for (int i = 0; i < HUB12_MAX_MARQUEES; i++) _mqs[i].attach(*this);
+  }
+  for (int i = 0; i < HUB12_MAX_MARQUEES; i++) {
+    Marquee& m = _mqs[i];
+    if (m.active()) continue;
+    // valores por defecto: la ventana puede venir de un uso anterior
+    m.shift = false;
+    m.stepPx = 1;
+    m.gap = -1;
+    m.stripMax = 0;
+    m.dir = dir;
+    m.start(x, y, w, h, text, spacing, stepMs);
+    return m.active() ? i : -1;
+  }
+  return -1;
+}
 
-  _mqTextW = textWidth(_mqText, _mqSpacing);
-  _mqX = _mqX0 + _mqW;   // entra desde la derecha
+HUB12_1DATA::Marquee* HUB12_1DATA::marquee(int id) {
+  if (!_mqs || id < 0 || id >= HUB12_MAX_MARQUEES) return nullptr;
+  return &_mqs[id];
+}
 
-  _mqLast = millis();
-  _mqEnabled = true;
+void HUB12_1DATA::marqueeRemove(int id) {
+  if (_mqs && id >= 0 && id < HUB12_MAX_MARQUEES) _mqs[id].stop();
 }
 
-void HUB12_1DATA::marqueeTick(bool on) {
-  if (!_mqEnabled || !_mqText || !_font) return;
+void HUB12_1DATA::marqueeRemoveAll() {
+  if (!_mqs) return;
+  for (int i = 0; i < HUB12_MAX_MARQUEES; i++) _mqs[i].stop();
+}
 
+// Un frame: todas las ventanas con el mismo 'now' y un solo update() (dirty rows).
+bool HUB12_1DATA::marqueeUpdate(bool on) {
+  if (!_font || !_mqs) return false;
   unsigned long now = millis();
-  if ((uint16_t)(now - _mqLast) < _mqStepMs) return;
-  _mqLast = now;
+  bool moved = false;
+  for (int i = 0; i < HUB12_MAX_MARQUEES; i++)
+    if (_mqs[i].step(now, on)) moved = true;
+  if (moved) update();
+  return moved;
+}
+
+// ---------- Marquee ----------
+void HUB12_1DATA::Marquee::start(int X, int Y, int W, int H, const char* t, uint8_t sp, uint16_t ms) {
+  text = nullptr;
+  if (!d || !t) return;
+
+  // recorte a pantalla
+  if (W <= 0 || H <= 0) return;
+  if (X < 0) { W += X; X = 0; }
+  if (Y < 0) { H += Y; Y = 0; }
+  if (X + W > (int)d->width())  W = d->width()  - X;
+  if (Y + H > (int)d->height()) H = d->height() - Y;
+  if (W <= 0 || H <= 0) return;
+
+  x0=X; y0=Y; w=W; h=H;
+  spacing = sp;
+  stepMs = ms;
+  text = t;
+
+  textW = d->textWidth(text, spacing);
+  resetPos();
+  shown = false;
+  last = millis();
+  if (stripMax) buildStrip();
+}
 
-  // limpiar SOLO la ventana
-  fillRect(_mqX0, _mqY0, _mqW, _mqH, false);
+void HUB12_1DATA::Marquee::setDirection(MarqueeDir dr) {
+  dir = dr;
+  shown = false;
+  if (!text) return;
+  resetPos();
+  if (stripMax) buildStrip();
+}
 
-  // clip a la ventana
-  setClipRect(_mqX0, _mqY0, _mqW, _mqH);
+// Posición inicial: el texto entra por el borde opuesto a la dirección.
+void HUB12_1DATA::Marquee::resetPos() {
+  switch (dir) {
+    case MQ_LEFT:  x = x0 + w; break;
+    case MQ_RIGHT: x = x0 - textW; break;
+    case MQ_UP:    y = y0 + h; break;
+    case MQ_DOWN:  y = y0 - (int)d->fontHeight(); break;
+  }
+}
 
-  // centra verticalmente según fuente actual
-  int yText = _mqY0 + (_mqH - (int)fontHeight()) / 2;
+void HUB12_1DATA::Marquee::tick(bool on) {
+  if (step(millis(), on)) d->update();
+}
 
-  drawText(_mqX, yText, _mqText, on, _mqSpacing);
+bool HUB12_1DATA::Marquee::step(unsigned long now, bool on) {
+  if (!d || !text) return false;
+  if ((uint16_t)(now - last) < stepMs) return false;
+  last = now;
+
+  // Shift: si la ventana muestra el texto stepPx más a la derecha, basta desplazarla.
+  int dx = shownX - x;
+  if (stripReady) {
+    drawStrip(on);
+  // Con doble buffer el back no tiene el frame anterior: siempre se redibuja.
+  } else if (shift && dir == MQ_LEFT && gap < 0 && shown && dx > 0 && dx < w && !d->isDoubleBuffer()) {
+    d->scrollLeft(x0, y0, w, h, dx);
+    drawEntering(x0 + w - dx, on);
+  } else {
+    redraw(on);
+  }
+  shownX = x;
+  shown = true;
 
-  clearClipRect();
+  advance();
+  return true;
+}
 
-  update();
+// Mueve stepPx sobre el eje de la dirección. Sin lazo, al salir del todo vuelve a
+// entrar por el otro borde; con lazo, la copia siguiente pasa a ser la primera.
+void HUB12_1DATA::Marquee::advance() {
+  bool vert = dir == MQ_UP || dir == MQ_DOWN;
+  int16_t& pos = vert ? y : x;
+  int win0 = vert ? y0 : x0;
+  int winLen = vert ? h : w;
+  int len = vert ? (int)d->fontHeight() : textW;
+  int32_t period = loopPeriod();
+
+  if (dir == MQ_LEFT || dir == MQ_UP) {
+    pos -= stepPx;
+    if (period) {
+      while (win0 - pos >= period) pos += period;
+    } else if (pos < win0 - len) {
+      pos = win0 + winLen;
+    }
+  } else {
+    pos += stepPx;
+    if (period) {
+      while (pos >= win0 + winLen) pos -= period;
+    } else if (pos > win0 + winLen) {
+      pos = win0 - len;
+    }
+  }
+}
 
-  // mover
-  _mqX--;
-  if (_mqX < (_mqX0 - _mqTextW)) _mqX = _mqX0 + _mqW;
+// Distancia entre el inicio de una copia del texto y la siguiente (0 = sin lazo continuo).
+int32_t HUB12_1DATA::Marquee::loopPeriod() const {
+  if (gap < 0) return 0;
+  bool vert = dir == MQ_UP || dir == MQ_DOWN;
+  int32_t p = (vert ? (int32_t)d->fontHeight() : (int32_t)textW) + gap;
+  return p > 0 ? p : 0;
 }
 
-void HUB12_1DATA::marqueeStop() {
-  _mqEnabled = false;
-  _mqText = nullptr;
+// Ventana completa: limpia y dibuja el texto recortado (y sus copias si hay lazo).
+void HUB12_1DATA::Marquee::redraw(bool on) {
+  d->fillRect(x0, y0, w, h, false);
+  d->setClipRect(x0, y0, w, h);
+  int yText = y0 + (h - (int)d->fontHeight()) / 2;   // centra vertical
+  int32_t period = loopPeriod();
+  switch (dir) {
+    case MQ_LEFT:
+      for (int32_t tx = x; tx < x0 + w; tx += period) {
+        d->drawText((int)tx, yText, text, on, spacing);
+        if (!period) break;
+      }
+      break;
+    case MQ_RIGHT:
+      for (int32_t tx = x; tx + textW > x0; tx -= period) {
+        d->drawText((int)tx, yText, text, on, spacing);
+        if (!period) break;
+      }
+      break;
+    case MQ_UP:
+    case MQ_DOWN: {
+      int xText = x0 + (w - textW) / 2;                // centra horizontal
+      int fh = d->fontHeight();
+      int32_t ty = y;
+      if (dir == MQ_UP) {
+        for (; ty < y0 + h; ty += period) { d->drawText(xText, (int)ty, text, on, spacing); if (!period) break; }
+      } else {
+        for (; ty + fh > y0; ty -= period) { d->drawText(xText, (int)ty, text, on, spacing); if (!period) break; }
+      }
+      break;
+    }
+  }
+  d->clearClipRect();
+  if (dir != MQ_LEFT) return;
+
+  // cursor al primer carácter que todavía no terminó de entrar
+  ci = 0; cs = 0;
+  int edge = x0 + w - x;   // primera columna (relativa al texto) aún fuera de la ventana
+  while (text[ci] && cs + (int)d->charWidth(text[ci]) <= edge) {
+    cs += d->charWidth(text[ci]) + spacing;
+    ci++;
+  }
+}
+
+// Dibuja solo las columnas [fromX, x0+w) (ya apagadas por scrollLeft): los
+// caracteres del cursor que caen ahí, con clip a esa franja.
+void HUB12_1DATA::Marquee::drawEntering(int fromX, bool on) {
+  int yText = y0 + (h - (int)d->fontHeight()) / 2;
+  int end = x0 + w - x;    // columna relativa al texto donde termina la franja
+  d->setClipRect(fromX, y0, x0 + w - fromX, h);
+
+  uint16_t i = ci;
+  int s = cs;
+  while (text[i] && s < end) {
+    uint8_t adv = d->charWidth(text[i]);
+    d->drawChar(x + s, yText, text[i], on);
+
+    // el carácter ya entró entero: el cursor pasa al siguiente
+    if (s + adv <= end && i == ci) { ci++; cs = s + adv + spacing; }
+    s += adv + spacing;
+    i++;
+  }
+  d->clearClipRect();
+}
+
+// ---------- Marquee: modo strip ----------
+HUB12_1DATA::Marquee::~Marquee() {
+  free(strip);
+}
+
+bool HUB12_1DATA::Marquee::setStrip(bool enable, uint16_t maxBytes) {
+  stripMax = enable ? maxBytes : 0;
+  shown = false;
+  if (!stripMax) {
+    stripReady = false;
+    free(strip);
+    strip = nullptr;
+    stripCap = 0;
+    return true;
+  }
+  if (!text) return true;   // se arma en start()
+  return buildStrip();
+}
+
+void HUB12_1DATA::Marquee::setLoopGap(int gapPx) {
+  gap = gapPx < 0 ? -1 : (int16_t)gapPx;
+  shown = false;
+  if (stripMax && text) buildStrip();
+}
+
+// Dimensiona la tira y dibuja el primer tramo. Sin lazo guarda el texto entero;
+// con lazo, un periodo más el ancho de la ventana (cubre cualquier posición).
+bool HUB12_1DATA::Marquee::buildStrip() {
+  stripReady = false;
+  if (!d || !text || !stripMax || !d->_font) return false;
+  if (dir != MQ_LEFT && dir != MQ_RIGHT) return false;   // vertical: redibujo
+  if (!glyphAtlasStride(d->_font)) return false;   // glifos de más de 32 px: sin tira
+
+  int32_t period = loopPeriod();
+  int32_t want = period ? period + w : textW;
+  if (want < 1) want = 1;
+  int32_t maxW = (int32_t)(stripMax / h) * 8;
+  if (want > maxW) {
+    if (maxW < w) return false;   // ni un tramo del ancho de la ventana
+    want = maxW;                  // texto largo: tramos que se redibujan al avanzar
+  }
+
+  uint16_t stride = (uint16_t)((want + 7) >> 3);
+  uint32_t bytes = (uint32_t)stride * h;
+  if (bytes > stripCap) {
+    free(strip);
+    strip = (uint8_t*)malloc(bytes);
+    stripCap = strip ? (uint16_t)bytes : 0;
+    if (!strip) return false;
+  }
+  stripStride = stride;
+  stripW = want;
+  renderStrip(dir == MQ_RIGHT ? textW - want : 0);   // el primer tramo que entra
+  stripReady = true;
+  return true;
+}
+
+// OR de 'bits' (bit 0 = columna pos) en una fila LSB-first de 'stride' bytes.
+static void stripOrBits(uint8_t* row, uint16_t stride, int32_t pos, uint32_t bits) {
+  if (pos < 0) {
+    if (pos <= -32) return;
+    bits >>= -pos;
+    pos = 0;
+  }
+  uint32_t i = (uint32_t)pos >> 3;
+  uint64_t v = (uint64_t)bits << (pos & 7);
+  while (v && i < stride) { row[i++] |= (uint8_t)v; v >>= 8; }
+}
+
+// Dibuja en la tira las columnas [c0, c0+stripW) del texto (con sus copias si hay
+// lazo: en 0, P, 2P... hacia la izquierda, en 0, -P, -2P... hacia la derecha).
+void HUB12_1DATA::Marquee::renderStrip(int32_t c0) {
+  memset(strip, 0, (size_t)stripStride * h);
+  stripC0 = c0;
+
+  int32_t end = c0 + stripW;
+  int32_t period = loopPeriod();
+  int yOfs = (h - (int)d->_fontH) / 2;   // mismo centrado que redraw()
+  int32_t base = 0;
+  if (period) {
+    int32_t q = c0 / period;
+    if (c0 % period && c0 < 0) q--;        // piso también con c0 negativo
+    base = q * period;
+    if (dir == MQ_LEFT && base < 0) base = 0;
+  }
+
+  for (; base < end; base += period) {
+    if (dir == MQ_RIGHT && base > 0) break;
+    int32_t s = base;
+    for (const char* p = text; *p && s < end; p++) {
+      uint8_t uc = (uint8_t)*p;
+      uint8_t adv = d->glyphAdvance(uc);
+      uint32_t ofs;
+      uint8_t cw;
+      if (s + adv > c0 && d->glyph(uc, ofs, cw)) {
+        uint8_t idx = (uint8_t)(uc - d->_fontFirst);
+        for (uint8_t r = 0; r < d->_fontH; r++) {
+          int sr = yOfs + r;
+          if (sr < 0 || sr >= h) continue;
+          uint32_t bits = d->glyphRow(idx, ofs, cw, r);
+          if (bits) stripOrBits(strip + (uint32_t)sr * stripStride, stripStride, s - c0, bits);
+        }
+      }
+      s += adv + spacing;
+    }
+    if (!period) break;
+  }
+}
+
+// Tick en modo strip: limpia la ventana y copia la porción visible de la tira.
+// Solo redibuja la tira cuando la ventana sale del tramo guardado.
+void HUB12_1DATA::Marquee::drawStrip(bool on) {
+  d->fillRect(x0, y0, w, h, false);
+  if (!on) return;
+
+  // Columnas del texto visibles [a, b). Con lazo las copias siguen más allá del
+  // texto en el sentido contrario al movimiento.
+  bool loop = loopPeriod() != 0;
+  int32_t o = (int32_t)x0 - x;   // columna del texto en el borde izquierdo de la ventana
+  int32_t a = o, b = o + w;
+  if (a < 0 && !(loop && dir == MQ_RIGHT)) a = 0;
+  if (b > textW && !(loop && dir == MQ_LEFT)) b = textW;
+  if (a >= b) return;
+  // fuera del tramo: el nuevo deja la ventana en el extremo desde donde avanza
+  if (a < stripC0) renderStrip(b - stripW);
+  else if (b > stripC0 + stripW) renderStrip(a);
+
+  d->setClipRect(x0, y0, w, h);
+  d->blit((int)(x0 + stripC0 - o), y0, strip, (int)stripW, h, ROP_OR, stripStride, true);
+  d->clearClipRect();
+}
+
+// ---------- Ticker ----------
+HUB12_1DATA::Ticker::~Ticker() {
+  free(buf);
+}
+
+bool HUB12_1DATA::Ticker::start(int X, int Y, int W, int H, uint16_t capacity, uint8_t sp, uint16_t ms) {
+  stop();
+  if (!d || !d->_font || capacity == 0) return false;
+
+  // recorte a pantalla
+  if (W <= 0 || H <= 0) return false;
+  if (X < 0) { W += X; X = 0; }
+  if (Y < 0) { H += Y; Y = 0; }
+  if (X + W > (int)d->width())  W = d->width()  - X;
+  if (Y + H > (int)d->height()) H = d->height() - Y;
+  if (W <= 0 || H <= 0) return false;
+
+  buf = (char*)calloc(capacity, 1);
+  if (!buf) return false;
+  cap = capacity;
+
+  x0=X; y0=Y; w=W; h=H;
+  spacing = sp;
+  stepMs = ms;
+  head = 0; count = 0;
+  cur = 0; curCol = 0; curLeft = 0;
+  blankCols = w;
+  fresh = true;
+  last = millis();
+
+  d->fillRect(x0, y0, w, h, false);
+  return true;
+}
+
+void HUB12_1DATA::Ticker::stop() {
+  if (buf) { free(buf); buf = nullptr; }
+  cap = 0; head = 0; count = 0;
+}
+
+size_t HUB12_1DATA::Ticker::write(uint8_t c) {
+  if (!buf) return 0;
+  if (c == '\r') return 1;
+  if (c == '\n') c = ' ';
+  if (count >= cap) return 0;
+  uint16_t i = head + count;
+  if (i >= cap) i -= cap;
+  buf[i] = (char)c;
+  count++;
+  return 1;
+}
+
+bool HUB12_1DATA::Ticker::pop(char& c) {
+  if (!count) return false;
+  c = buf[head];
+  if (++head == cap) head = 0;
+  count--;
+  return true;
+}
+
+void HUB12_1DATA::Ticker::tick(bool on) {
+  if (step(millis(), on)) d->update();
+}
+
+bool HUB12_1DATA::Ticker::step(unsigned long now, bool on) {
+  if (!d || !buf || !d->_font) return false;
+  if ((uint16_t)(now - last) < stepMs) return false;
+  last = now;
+
+  // lo que haya en la fuente, hasta llenar el buffer
+  while (src && count < cap && src->available() > 0) {
+    int c = src->read();
+    if (c < 0) break;
+    write((uint8_t)c);
+  }
+
+  // nada pendiente y la ventana ya quedó vacía: no hay que mover nada
+  if (!count && curLeft <= 0 && blankCols >= w) return false;
+
+  int n = stepPx < w ? stepPx : w;
+  shiftWindow(n);
+  emit(n, on);
+  return true;
+}
+
+// Corre la ventana n columnas a la izquierda y deja apagadas las n que entran.
+void HUB12_1DATA::Ticker::shiftWindow(int n) {
+  if (fresh) {
+    // recién empezado: la ventana parte vacía (en doble buffer el front puede
+    // tener otra cosa)
+    d->fillRect(x0, y0, w, h, false);
+    fresh = false;
+    return;
+  }
+  if (d->isDoubleBuffer() && d->_fbFront && d->_fbFront != d->_fb) {
+    // El back no tiene el frame anterior: se copia del front ya corrido.
+    uint16_t stride = d->_w >> 3;
+    int bx = x0 & 7;
+    if (w > n) {
+      d->setClipRect(x0, y0, w - n, h);
+      for (uint8_t k = 0; k < d->_planes; k++)   // plano por plano, sin remapear el nivel
+        d->blitRaw(x0 - bx - n, y0, d->_fbFront + k * d->_fbBytes + (uint32_t)y0 * stride + (x0 >> 3),
+                   w + bx, h, ROP_COPY, stride, true, true, (int8_t)k);
+      d->clearClipRect();
+    }
+    d->fillRect(x0 + w - n, y0, n, h, false);
+    return;
+  }
+  d->scrollLeft(x0, y0, w, h, n);
+}
+
+// Dibuja las n columnas del borde derecho tomando caracteres del buffer.
+void HUB12_1DATA::Ticker::emit(int n, bool on) {
+  int fromX = x0 + w - n;
+  int yText = y0 + (h - (int)d->fontHeight()) / 2;   // centra vertical
+  d->setClipRect(fromX, y0, n, h);
+
+  int X = fromX;
+  while (n > 0) {
+    if (curLeft <= 0) {
+      if (!pop(cur)) {               // sin texto: entran columnas vacías
+        blankCols += n;
+        if (blankCols > w) blankCols = w;
+        break;
+      }
+      curCol = 0;
+      curLeft = (int16_t)(d->glyphAdvance((uint8_t)cur) + spacing);
+    }
+    int take = n < curLeft ? n : curLeft;
+    d->drawChar(X - curCol, yText, cur, on);
+    blankCols = 0;
+    curCol += take;
+    curLeft -= take;
+    X += take;
+    n -= take;
+  }
+  d->clearClipRect();
 }
 #if defined(ESP32)
 
@@ -851,28 +2809,81 @@ void HUB12_1DATA::_arTimerCb(void* arg) {
   }
 }
 
+// Fin del tiempo ON de la fila: apaga OE sin ocupar el task de refresco.
+void HUB12_1DATA::_oeTimerCb(void* arg) {
+  HUB12_1DATA* self = (HUB12_1DATA*)arg;
+  fastLow(self->_fOE);
+}
+
 void HUB12_1DATA::_arTaskFn(void* arg) {
   HUB12_1DATA* self = (HUB12_1DATA*)arg;
   for (;;) {
-    // Espera "tick" del timer. Si llegaron varios, ulTaskNotifyTake devuelve >1.
-    // Nosotros hacemos UN refresh por despertar para evitar backlog infinito.
-    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    // Un tick = una fila. Si llegaron varios, ulTaskNotifyTake devuelve >1.
+    // Nosotros cargamos UNA fila por despertar para evitar backlog infinito;
+    // los sobrantes se cuentan como missedTicks.
+    uint32_t notified = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     if (!self->_arEnabled) {
-      vTaskDelay(pdMS_TO_TICKS(10));
+      // Apagado: avisa a arPark() y no toca más los timers hasta el próximo start.
+      xSemaphoreGive(self->_arParked);
+      continue;
+    }
+
+    if (self->_planes > 1) {
+      // Escala de grises: ranuras de distinto largo, el timer se rearma en cada
+      // plano (desde aquí, antes del shift, para que la ranura lo incluya).
+      // El plazo es absoluto: la latencia de cada despertar no se suma a la
+      // ranura siguiente ni altera las proporciones 1:2:4 entre planos.
+      // Con ranuras variables el histograma de jitter no aplica.
+      // El timer nunca dispara antes de _arDueUs: un despertar previo no es suyo
+      // (aviso viejo) y la ranura en curso sigue armada, así que no se toca nada
+      // para no cortar ni correr la cadena. Solo el task la rearma, después de
+      // ver _arEnabled; al apagar, arPark() la corta y startAutoRefresh() la reinicia.
+      int64_t now = esp_timer_get_time();
+      if (now < self->_arDueUs) continue;
+      esp_timer_stop(self->_oeTimer);
+      uint8_t k = self->_planeNext;
+      uint32_t slot = self->planeOnUs(self->_arPeriodUs / 4u, k);
+      self->_arDueUs += slot;
+      if (self->_arDueUs <= now) {
+        // Atrasado: la ranura ya venció sin mostrarse. Se re-ancla y las ranuras
+        // salteadas (medidas con el largo de esta) cuentan como ticks perdidos.
+        if (self->_statsOn)
+          self->_stats.missedTicks += 1u + (uint32_t)((now - self->_arDueUs) / slot);
+        self->_arDueUs = now + slot;
+      }
+      if (self->_statsOn) self->_stats.ticks++;
+      esp_timer_start_once(self->_arTimer, (uint64_t)(self->_arDueUs - now));
+      self->refreshRow();
+      if (self->_rowOnUs < slot) esp_timer_start_once(self->_oeTimer, self->_rowOnUs);
       continue;
     }
-    self->refresh();
+
+    // Cancelar el apagado pendiente de la fila anterior antes de mostrar la nueva.
+    esp_timer_stop(self->_oeTimer);
+    if (self->_statsOn) self->statWake(notified);
+    self->refreshRow();
+
+    // Si el tiempo ON cubre toda la ranura, OE queda encendido hasta la próxima fila.
+    // Con el limitador cada fila trae el suyo; una fila vacía ya dejó OE apagado.
+    if (self->_rowOnUs < self->_arPeriodUs / 4u) {
+      esp_timer_start_once(self->_oeTimer, self->_rowOnUs);
+    }
   }
 }
 
 bool HUB12_1DATA::startAutoRefresh(uint32_t periodUs) {
   if (_arEnabled) return true;
 
-  // refresh() tarda aprox: 4*_onTimeUs + overhead (shift/latch).
-  // Si el periodo es menor, el timer se satura y el ESP32 termina colgándose.
-  uint32_t minUs = (uint32_t)_onTimeUs * 4u + 300u; // margen
-  if (periodUs < minUs) periodUs = minUs;
-  _arPeriodUs = periodUs;
+  // periodUs = ciclo completo de 4 filas; el timer dispara una vez por fila.
+  _arReqUs = periodUs;
+  _arPeriodUs = arPeriodFor(periodUs);
+  _rowNext = 0;
+  _planeNext = 0;
+
+  // waitForVSync() duerme en este semáforo; sin él sondea
+  if (!_vsyncSem) _vsyncSem = xSemaphoreCreateBinary();
+  if (!_arParked) _arParked = xSemaphoreCreateBinary();
+  if (!_arParked) return false;
 
   // Task dedicado
   if (!_arTask) {
@@ -881,33 +2892,92 @@ bool HUB12_1DATA::startAutoRefresh(uint32_t periodUs) {
   }
 
   esp_timer_create_args_t args = {};
-  args.callback = &HUB12_1DATA::_arTimerCb;
+  args.callback = &HUB12_1DATA::_oeTimerCb;
   args.arg = this;
   args.dispatch_method = ESP_TIMER_TASK;   // importante: no ISR
+  args.name = "hub12_oe";
+
+  if (!_oeTimer && esp_timer_create(&args, &_oeTimer) != ESP_OK) {
+    _oeTimer = nullptr;
+    return false;
+  }
+
+  args.callback = &HUB12_1DATA::_arTimerCb;
   args.name = "hub12_ar";
 
   if (esp_timer_create(&args, &_arTimer) != ESP_OK) {
     _arTimer = nullptr;
     return false;
   }
-  if (esp_timer_start_periodic(_arTimer, _arPeriodUs) != ESP_OK) {
+  uint32_t first = planeOnUs(_arPeriodUs / 4u, 0);
+  _arDueUs = esp_timer_get_time() + first;
+
+  // El flag va antes de armar: el primer tick ya lo encuentra activo. Los avisos
+  // que el task dio estando apagado (despertares sueltos) se descartan.
+  xSemaphoreTake(_arParked, 0);
+  _arEnabled = true;
+  esp_err_t err = (_planes > 1) ? esp_timer_start_once(_arTimer, first)
+                                : esp_timer_start_periodic(_arTimer, _arPeriodUs / 4u);
+  if (err != ESP_OK) {
+    arPark();
     esp_timer_delete(_arTimer);
     _arTimer = nullptr;
     return false;
   }
-
-  _arEnabled = true;
   return true;
 }
 
+// Periodo real para el pedido: como en 1.0.0 la ranura de fila cubre el tiempo ON
+// (el mayor que puede tocarle a una fila, con el limitador) más el shift (~75 us
+// por fila y plano), así que onTimeUs sigue mandando en el brillo. En escala de
+// grises la ranura más corta (plano 0) es 1/(2^bits - 1) de la de fila; nunca
+// menos de 100 us por unidad.
+uint32_t HUB12_1DATA::arPeriodFor(uint32_t periodUs) const {
+  uint32_t on = _onTimeUs;
+  if (_powerLeds && _powerMaxUs > on) on = _powerMaxUs;
+  uint32_t minUs = 4u * (on + 75u * maxLevel());
+  if (minUs < 400u * maxLevel()) minUs = 400u * maxLevel();
+  return periodUs < minUs ? minUs : periodUs;
+}
+
+// onTimeUs o el limitador cambiaron con el auto-refresh andando: reajusta el periodo.
+void HUB12_1DATA::arRetime() {
+  if (!_arEnabled) return;
+  uint32_t p = arPeriodFor(_arReqUs);
+  if (p == _arPeriodUs) return;
+  _arPeriodUs = p;   // en gris el task lo toma en la próxima ranura
+  if (_planes == 1) {
+    esp_timer_stop(_arTimer);
+    esp_timer_start_periodic(_arTimer, p / 4u);
+  }
+}
+
+// Apaga el auto-refresh y espera al task. Puede estar a mitad de una fila, ya
+// pasado el chequeo de _arEnabled, parando o rearmando los timers: se lo despierta
+// y, cuando avisa que vio el flag apagado, se paran otra vez por si rearmó alguno.
+// Desde ahí los timers se pueden borrar. No llamar desde el task (onVSync()).
+void HUB12_1DATA::arPark() {
+  _arEnabled = false;
+  if (_arTimer) esp_timer_stop(_arTimer);
+  if (_oeTimer) esp_timer_stop(_oeTimer);
+  xTaskNotifyGive(_arTask);
+  xSemaphoreTake(_arParked, portMAX_DELAY);
+  if (_arTimer) esp_timer_stop(_arTimer);
+  if (_oeTimer) esp_timer_stop(_oeTimer);
+}
+
 void HUB12_1DATA::stopAutoRefresh() {
   if (!_arEnabled) return;
+  arPark();
   if (_arTimer) {
-    esp_timer_stop(_arTimer);
     esp_timer_delete(_arTimer);
     _arTimer = nullptr;
   }
-  _arEnabled = false;
+  if (_oeTimer) {
+    esp_timer_delete(_oeTimer);
+    _oeTimer = nullptr;
+  }
+  fastLow(_fOE);
 
   // No destruimos el task para evitar fragmentación; queda dormido.
 }
@@ -935,20 +3005,7 @@ void HUB12_1DATA::setTextSize(uint8_t size) {
 
 uint8_t HUB12_1DATA::charWidth(char c) const {
   if (!_font) return 0;
-
-  const uint8_t fontW = pgm_read_byte(_font + 2);
-  const uint8_t first = pgm_read_byte(_font + 4);
-  const uint8_t count = pgm_read_byte(_font + 5);
-
-  // size==0 => fuente fija (System5x7, etc)
-  const uint16_t sizeBytes = (uint16_t)pgm_read_byte(_font) | ((uint16_t)pgm_read_byte(_font + 1) << 8);
-  if (sizeBytes == 0) return fontW;
-
-  int idx = (int)c - (int)first;
-  if (idx < 0 || idx >= (int)count) return fontW;
-
-  const uint8_t* widths = _font + 6;
-  return pgm_read_byte(widths + idx);
+  return glyphAdvance((uint8_t)c);
 }
 
 size_t HUB12_1DATA::write(uint8_t c) {
@@ -1,10 +1,22 @@
 #pragma once
-#include <Arduino.h>
-#include <Print.h>
+#if defined(ARDUINO)
+  #include <Arduino.h>
+  #include <Print.h>
+#else
+  #include "HUB12_host.h"   // build en PC: reemplazo mínimo de Arduino + panel virtual
+#endif
+#include <atomic>
 #if defined(ESP32)
   #include "esp_timer.h"
   #include "freertos/FreeRTOS.h"
   #include "freertos/task.h"
+  #include "freertos/semphr.h"
+  #include "driver/spi_master.h"
+#endif
+
+// Periférico SPI usado por setSpiOutput() (SPI2 = HSPI/FSPI según el chip)
+#if defined(ESP32) && !defined(HUB12_SPI_HOST)
+  #define HUB12_SPI_HOST SPI2_HOST
 #endif
 
 // Estructura para GPIO rápido (se usa como miembro de clase)
@@ -13,71 +25,256 @@ struct HUB12FastPin {
   bool hiBank = false; // false: GPIO <32, true: GPIO >=32
 };
 
+// Máximo de líneas DATA en paralelo (PinsMulti). Se puede bajar, no subir: el
+// bit-slice reparte cada flanco de CLK en un byte (bit c = cadena c) y la tabla
+// de máscaras GPIO tiene 256 entradas; el panel virtual también emula hasta 8.
+#ifndef HUB12_MAX_CHAINS
+  #define HUB12_MAX_CHAINS 8
+#endif
+static_assert(HUB12_MAX_CHAINS >= 1 && HUB12_MAX_CHAINS <= 8, "HUB12_MAX_CHAINS: 1..8");
+
+// Posición de un panel de la cadena dentro del framebuffer (precalculado en begin())
+struct HUB12PanelMap {
+  uint32_t fbOfs = 0;   // byte del framebuffer de la esquina sup-izq del panel
+  bool mirror = false;  // panel invertido (fila impar en serpentina)
+  uint16_t fbPanel = 0; // índice del panel en orden de framebuffer (py*panelsX + px)
+};
+
+// Orden de los paneles para la variante con geometría fija HUB12<> (HUB12.h)
+enum HUB12Layout : uint8_t { HUB12_LINEAR, HUB12_SERPENTINE };
+
+// Buffers provistos por fuera (HUB12<> los tiene como arrays miembro): begin()
+// los usa en lugar de calloc y end() no los libera. Tamaños en HUB12.h.
+struct HUB12Storage {
+  uint8_t* fb = nullptr;
+  uint8_t* scan[3] = { nullptr, nullptr, nullptr };
+  uint16_t* dirtyRows = nullptr;
+  uint8_t* litCnt = nullptr;
+  HUB12PanelMap* panelMap = nullptr;
+  uint8_t planes = 1;             // setGrayscale() no puede cambiarlo
+};
+
+// Glifo de una fuente DMD2 de ancho variable: offset de sus datos (relativo al
+// inicio de los datos, después de la tabla de anchos) y ancho en columnas.
+// El alto es el de la fuente. Ver HUB12_1DATA::buildGlyphIndex().
+struct HUB12Glyph {
+  uint16_t ofs;
+  uint8_t w;
+};
+
+// Estadísticas de refresco (setStatsEnabled/getStats). Tiempos en microsegundos,
+// scanLock* en ciclos de CPU (solo ESP32; en PC no se mide el intercambio).
+// jitter[i]: desvío |real - esperado| del periodo entre despertares del task de
+// auto-refresh, con límites 2,5,10,20,50,100,200 us (el último bin es >= 200 us).
+#define HUB12_JITTER_BINS 8
+
+// Ventanas del gestor de marquesinas (marqueeAdd/marqueeUpdate)
+#ifndef HUB12_MAX_MARQUEES
+  #define HUB12_MAX_MARQUEES 4
+#endif
+
+// Profundidad máxima de la cola de frames con hora (setFrameQueue/queueFrame)
+#ifndef HUB12_FRAME_QUEUE_MAX
+  #define HUB12_FRAME_QUEUE_MAX 8
+#endif
+
+// Páginas pre-codificadas (bakePage) y entradas de la lista de reproducción
+#ifndef HUB12_MAX_PAGES
+  #define HUB12_MAX_PAGES 20
+#endif
+#ifndef HUB12_MAX_PLAYLIST
+  #define HUB12_MAX_PLAYLIST 32
+#endif
+
+// Límite por defecto de la tira de la marquesina en modo strip (Marquee::setStrip)
+#ifndef HUB12_MARQUEE_STRIP_MAX
+  #define HUB12_MARQUEE_STRIP_MAX 4096
+#endif
+
+struct HUB12Stats {
+  uint32_t refreshes = 0;       // llamadas a refresh()/refreshRow()
+  uint32_t ticks = 0;           // despertares del task de auto-refresh
+  uint32_t missedTicks = 0;     // ticks coalescidos: refresco atrasado, fila no mostrada a tiempo
+  uint32_t refreshMinUs = 0, refreshAvgUs = 0, refreshMaxUs = 0;
+  uint64_t refreshTotalUs = 0;
+
+  uint32_t builds = 0;          // buildScan() o publicación en modo nativo
+  uint32_t buildMinUs = 0, buildAvgUs = 0, buildMaxUs = 0;
+  uint64_t buildTotalUs = 0;
+
+  uint32_t scanLocks = 0;       // intercambios atómicos del triple buffer de scan
+  uint32_t scanLockMaxCycles = 0;
+  uint64_t scanLockTotalCycles = 0;
+
+  uint32_t jitter[HUB12_JITTER_BINS] = {};
+};
+
+// Página guardada en formato scan (todas las filas y planos), cruda o en RLE
+// PackBits. _litRow/_litBlank del limitador van con la página.
+struct HUB12Page {
+  uint8_t* data = nullptr;
+  uint32_t bytes = 0;       // tamaño de data
+  bool rle = false;
+  uint32_t litRow[4] = {};
+  uint16_t litBlank = 0xFFFF;
+};
+
+// Contadores de la cola de frames (getQueueStats). Siempre activos.
+struct HUB12QueueStats {
+  uint32_t queued = 0;      // aceptados por queueFrame()
+  uint32_t full = 0;        // rechazados por cola llena
+  uint32_t shown = 0;       // tomados por el refresco
+  uint32_t dropped = 0;     // vencidos sin mostrarse: ya había uno posterior vencido
+  uint32_t underruns = 0;   // tomados un vsync tarde o más (no estaban en la cola a tiempo)
+  uint32_t maxLateUs = 0;   // mayor retraso entre la hora pedida y el vsync que lo tomó
+};
+
 class HUB12_1DATA : public Print {
 public:
+// Dirección de una marquesina: hacia dónde se mueve el texto
+enum MarqueeDir : uint8_t { MQ_LEFT, MQ_RIGHT, MQ_UP, MQ_DOWN };
+
 struct Marquee {
   HUB12_1DATA* d = nullptr;
 
   int16_t x0=0, y0=0, w=0, h=0;     // ventana
   int16_t x=0;                      // posición actual del texto
+  int16_t y=0;                      // idem en vertical (MQ_UP/MQ_DOWN)
+  MarqueeDir dir=MQ_LEFT;
   int16_t textW=0;                  // ancho del texto en px
   uint8_t spacing=1;
   uint16_t stepMs=40;
   unsigned long last=0;
   const char* text=nullptr;
 
-  void attach(HUB12_1DATA& дисп) { d = &дисп; }
+  // Modo shift: desplaza la ventana en el framebuffer y dibuja solo las columnas
+  // que entran. El costo por tick depende del alto de la ventana, no del texto.
+  bool shift=false;
+  uint8_t stepPx=1;                 // px por tick (ambos modos)
+  int16_t shownX=0;                 // x del texto que está en pantalla
+  bool shown=false;                 // la ventana ya muestra el texto en shownX
+  uint16_t ci=0;                    // cursor: primer carácter que aún puede entrar
+  int16_t cs=0;                     // inicio de ese carácter (relativo al texto)
+
+  // Modo strip: el texto se dibuja una sola vez en una tira 1bpp fuera de pantalla
+  // y cada tick copia a la ventana la porción visible (costo fijo). Si la tira no
+  // entra en stripMax bytes guarda un tramo que se redibuja cuando se agota.
+  uint16_t stripMax=0;              // límite en bytes (0 = apagado)
+  int16_t gap=-1;                   // -1: el texto sale y vuelve a entrar; >=0: lazo continuo
+  uint8_t* strip=nullptr;
+  uint16_t stripCap=0;              // bytes reservados
+  uint16_t stripStride=0;           // bytes por fila de la tira
+  int32_t stripW=0;                 // columnas de la tira
+  int32_t stripC0=0;                // columna del texto que está en la columna 0 de la tira
+  bool stripReady=false;
+
+  Marquee() = default;
+  Marquee(const Marquee&) = delete;
+  Marquee& operator=(const Marquee&) = delete;
+  ~Marquee();
 
-  void start(int X, int Y, int W, int H, const char* t, uint8_t sp=1, uint16_t ms=40) {
-    if (!d || !t) return;
-    text = t;
-    spacing = sp;
-    stepMs = ms;
-
-    // recorte a pantalla
-    if (W <= 0 || H <= 0) return;
-    if (X < 0) { W += X; X = 0; }
-    if (Y < 0) { H += Y; Y = 0; }
-    if (X + W > (int)d->width())  W = d->width()  - X;
-    if (Y + H > (int)d->height()) H = d->height() - Y;
-    if (W <= 0 || H <= 0) return;
-
-    x0=X; y0=Y; w=W; h=H;
-
-    textW = d->textWidth(text, spacing);
-    x = x0 + w;         // entra desde la derecha
-    last = millis();
-  }
-
-  void tick(bool on=true) {
-    if (!d || !text) return;
-    unsigned long now = millis();
-    if ((uint16_t)(now - last) < stepMs) return;
-    last = now;
+  void attach(HUB12_1DATA& дисп) { d = &дисп; }
 
-    // limpia SOLO la ventana
-    d->fillRect(x0, y0, w, h, false);
+  void start(int X, int Y, int W, int H, const char* t, uint8_t sp=1, uint16_t ms=40);
+  void setShift(bool enable=true, uint8_t px=1) { shift = enable; stepPx = px ? px : 1; shown = false; }
+  // maxBytes acota la RAM de la tira; false si ni un tramo del ancho de la ventana entra.
+  bool setStrip(bool enable=true, uint16_t maxBytes=HUB12_MARQUEE_STRIP_MAX);
+  // gapPx >= 0: el texto se repite sin pausa, separado gapPx columnas. -1 = clásico.
+  void setLoopGap(int gapPx);
+  // Vertical: el texto (una línea, centrado) sube o baja; sin modos shift ni strip.
+  void setDirection(MarqueeDir dr);
+  void stop() { text = nullptr; stripReady = false; }
+  bool active() const { return text != nullptr; }
+  void tick(bool on=true);
+  // Avanza un paso si ya pasaron stepMs desde el anterior; no llama update().
+  bool step(unsigned long now, bool on=true);
 
-    // clip
-    d->setClipRect(x0, y0, w, h);
+private:
+  void redraw(bool on);
+  void drawEntering(int fromX, bool on);
+  void resetPos();
+  void advance();
+  int32_t loopPeriod() const;
+  bool buildStrip();
+  void renderStrip(int32_t c0);
+  void drawStrip(bool on);
+};
 
-    // centra vertical
-    int yText = y0 + (h - (int)d->fontHeight()) / 2;
-    d->drawText(x, yText, text, on, spacing);
+// Ticker continuo: el texto llega de a poco (print()/write() o un Stream) a un
+// buffer circular de tamaño fijo y se dibuja solo en las columnas que entran por
+// la derecha. Cada carácter sale del buffer al empezar a entrar; lo que ya está en
+// pantalla se desplaza en el framebuffer. La RAM no crece con la duración del feed.
+struct Ticker : public Print {
+  HUB12_1DATA* d = nullptr;
 
-    d->clearClipRect();
-    d->update();
+  int16_t x0=0, y0=0, w=0, h=0;     // ventana
+  uint8_t spacing=1;
+  uint8_t stepPx=1;                 // px por tick
+  uint16_t stepMs=40;
+  unsigned long last=0;
+  Stream* src=nullptr;              // fuente opcional, se lee en cada paso
+
+  char* buf=nullptr;                // buffer circular
+  uint16_t cap=0, head=0, count=0;
+  char cur=0;                       // carácter que está entrando
+  int16_t curCol=0;                 // columnas ya dibujadas de cur
+  int16_t curLeft=0;                // columnas que faltan (avance + spacing)
+  int16_t blankCols=0;              // columnas vacías seguidas en el borde derecho
+  bool fresh=false;                 // primer paso: la ventana parte vacía
+
+  Ticker() = default;
+  Ticker(const Ticker&) = delete;
+  Ticker& operator=(const Ticker&) = delete;
+  ~Ticker();
+
+  void attach(HUB12_1DATA& disp) { d = &disp; }
+
+  // Limpia la ventana y reserva 'capacity' caracteres; false sin fuente/ventana/RAM.
+  bool start(int X, int Y, int W, int H, uint16_t capacity=128, uint8_t sp=1, uint16_t ms=40);
+  void stop();
+  void setSource(Stream* s) { src = s; }
+  void setStepPx(uint8_t px) { stepPx = px ? px : 1; }
+  void clear() { head = 0; count = 0; }   // descarta lo pendiente; lo visible sigue saliendo
+  uint16_t space() const { return cap - count; }
+  bool active() const { return buf != nullptr; }
+
+  // '\r' se ignora y '\n' pasa a espacio. Con el buffer lleno devuelve 0 (se descarta).
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+  void tick(bool on=true);
+  // Avanza si le toca; false si no pasó stepMs o no hay nada que mover. No llama update().
+  bool step(unsigned long now, bool on=true);
 
-    // mueve
-    x--;
-    if (x < (x0 - textW)) x = x0 + w;
-  }
+private:
+  bool pop(char& c);
+  void shiftWindow(int n);
+  void emit(int n, bool on);
 };
 
 // Marquesina (scroll horizontal dentro de un rectángulo)
 void marqueeStart(int x, int y, int w, int h, const char* text, uint8_t spacing = 1, uint16_t stepMs = 40);
 void marqueeTick(bool on = true);
 void marqueeStop();
+// Modo shift (ver Marquee::setShift); stepPx > 1 para scroll rápido.
+void marqueeSetShift(bool enable = true, uint8_t stepPx = 1) { _mq.setShift(enable, stepPx); }
+// Modo strip (ver Marquee::setStrip) y lazo continuo (Marquee::setLoopGap)
+bool marqueeSetStrip(bool enable = true, uint16_t maxBytes = HUB12_MARQUEE_STRIP_MAX) { return _mq.setStrip(enable, maxBytes); }
+void marqueeSetLoopGap(int gapPx) { _mq.setLoopGap(gapPx); }
+
+// Gestor de marquesinas: hasta HUB12_MAX_MARQUEES ventanas, cada una con su
+// velocidad y dirección. marqueeUpdate() las avanza con un solo millis() y hace
+// un único update() si alguna se movió. Devuelve el id o -1 (sin lugar/ventana vacía).
+int marqueeAdd(int x, int y, int w, int h, const char* text, uint8_t spacing = 1,
+               uint16_t stepMs = 40, MarqueeDir dir = MQ_LEFT);
+Marquee* marquee(int id);   // para setShift/setStrip/setLoopGap/...; nullptr si no existe
+void marqueeRemove(int id);
+void marqueeRemoveAll();
+bool marqueeUpdate(bool on = true);
+
+// Desplaza la región px columnas a la izquierda; las columnas que entran por la
+// derecha quedan apagadas. Por palabras de 32 bits; no respeta setClipRect().
+void scrollLeft(int x, int y, int w, int h, int px);
 
 uint8_t fontHeight() const;
 uint8_t fontWidth() const;
@@ -92,7 +289,23 @@ int textWidth(const char* s, uint8_t spacing = 1);
 void drawCharScaled(int x, int y, char c, uint8_t scale = 2, bool on = true);
 void drawTextScaled(int x, int y, const char* s, uint8_t scale = 2, bool on = true, uint8_t spacing = 1);
 
-void setFont(const uint8_t* font);                 // fuente estilo DMD2
+// Fuente estilo DMD2. Cachea el header y, si es de ancho variable, arma un índice
+// de glifos (4 bytes por carácter) para no sumar anchos en cada drawChar().
+// glyphs: índice precalculado con buildGlyphIndex() (no se copia ni se libera).
+// atlas: atlas precalculado con buildGlyphAtlas() (se usa aunque setGlyphAtlas() esté apagado).
+void setFont(const uint8_t* font, const HUB12Glyph* glyphs = nullptr, const uint8_t* atlas = nullptr);
+// Llena out[0..count-1] para 'font'. Devuelve count (0 si es de ancho fijo).
+static uint8_t buildGlyphIndex(const uint8_t* font, HUB12Glyph* out);
+
+// Atlas de glifos: cada carácter traspuesto a filas de bits (bit 0 = columna
+// izquierda), así drawChar() escribe una fila entera por operación en vez de un
+// pixel. Cuesta count * alto * ceil(anchoMax/8) bytes de RAM; solo fuentes de
+// hasta 32 px de ancho. Se arma en setFont() (y ahora, si ya hay fuente).
+// Devuelve false si no hay RAM o la fuente es muy ancha (se dibuja por pixel).
+bool setGlyphAtlas(bool enable = true);
+bool isGlyphAtlas() const { return _atlas != nullptr; }
+// Bytes del atlas de 'font' (0 = no soportado). Con out != nullptr además lo llena.
+static uint32_t buildGlyphAtlas(const uint8_t* font, uint8_t* out);
 void drawChar(int x, int y, char c, bool on = true);
 void drawText(int x, int y, const char* s, bool on = true, uint8_t spacing = 1);
 
@@ -138,8 +351,23 @@ void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, bool on = true
     int data;
   };
 
+  // Varias cadenas en paralelo: comparten CLK/LAT/OE/A/B y cada una tiene su DATA.
+  // Los paneles (en orden de cadena) se reparten en bloques iguales: cadena c =
+  // paneles [c*P, (c+1)*P), P = total/chains. Todos los DATA en el mismo banco GPIO
+  // (todos <32 o todos >=32). El shift de cada fila dura 1/chains.
+  struct PinsMulti {
+    int oe;
+    int a;
+    int b;
+    int clk;
+    int lat;
+    uint8_t chains;
+    int data[HUB12_MAX_CHAINS];
+  };
+
   // serpentine=true: recomendado para arreglos 3x2 típicos (fila 2 al revés)
   HUB12_1DATA(const Pins& pins, uint8_t panelsX, uint8_t panelsY, bool serpentine = true);
+  HUB12_1DATA(const PinsMulti& pins, uint8_t panelsX, uint8_t panelsY, bool serpentine = true);
   ~HUB12_1DATA();
 
   bool begin();
@@ -149,7 +377,21 @@ void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, bool on = true
   uint16_t height() const { return _h; }
 
   // Brillo: tiempo ON por fila (microsegundos). Más = más brillo (y más consumo).
-  void setOnTimeUs(uint16_t us) { _onTimeUs = us; }
+  // Con auto-refresh el periodo se estira para que la ranura de fila lo cubra (como en 1.0.0).
+  void setOnTimeUs(uint16_t us);
+
+  // Limitador por fila: update() cuenta los LEDs encendidos de cada fila del scan y
+  // el refresco limita su carga a 'leds' LEDs x onTimeUs: una fila con más LEDs se
+  // enciende onTimeUs * leds / encendidos; con maxOnUs > onTimeUs las filas con menos
+  // se alargan hasta maxOnUs (misma carga por fila). leds = 0 lo desactiva.
+  // Las filas (o planos) sin ningún LED no se cargan y OE queda apagado, siempre.
+  void setPowerBudget(uint32_t leds, uint16_t maxOnUs = 0);
+  uint32_t powerBudget() const { return _powerLeds; }
+  // LEDs encendidos en la fila r (0..3) del último frame publicado; en escala de grises
+  // ponderados por plano y expresados en LEDs a nivel máximo.
+  uint32_t rowLit(uint8_t r) const;
+  // Tiempo ON que le tocó a la fila que mostró el último refreshRow() (0 = vacía).
+  uint32_t rowOnTimeUs() const { return _rowOnUs; }
 
   // Framebuffer
   void clear();
@@ -163,48 +405,216 @@ void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, bool on = true
   void fillRect(int x, int y, int w, int h, bool on = true);
   void drawLine(int x0, int y0, int x1, int y1, bool on = true);
 
+  // Bitmaps 1bpp: filas de ceil(w/8) bytes (o srcStride), MSB primero como Adafruit
+  // GFX (lsbFirst=true: bit 0 = pixel izquierdo, como XBM). RAM o PROGMEM.
+  // Respetan setClipRect() y cualquier x destino.
+  enum RasterOp : uint8_t {
+    ROP_COPY,     // destino = bitmap (opaco)
+    ROP_OR,       // enciende los bits 1 (transparente)
+    ROP_AND,      // apaga donde el bitmap es 0
+    ROP_XOR,      // invierte donde el bitmap es 1
+    ROP_ANDNOT    // apaga donde el bitmap es 1 (borrar con máscara)
+  };
+  void blit(int x, int y, const uint8_t* src, int w, int h, RasterOp op = ROP_COPY,
+            uint16_t srcStride = 0, bool lsbFirst = false);
+  // Transparente: on -> enciende los bits 1, off -> los apaga. El resto no cambia.
+  void drawBitmap(int x, int y, const uint8_t* bmp, int w, int h, bool on = true);
+
   // Render
-  void update();   // reconstruye scan buffers si hubo cambios
-  void refresh();  // llamar MUY seguido (loop)
+  // update() arma el frame en el scan libre y lo publica con un intercambio atómico
+  // (triple buffer). refresh()/refreshRow() solo toman el último frame publicado al
+  // inicio de cada ciclo de 4 filas; nunca convierten. Un solo hilo dibuja/llama
+  // update() y uno solo refresca.
+  void update();   // reconstruye el scan si hubo cambios y lo publica
+  void invalidate(); // marca todo para reconstruir en el próximo update()
+  void refresh();  // llamar MUY seguido (loop). Bloquea ~4*_onTimeUs
+  // Carga y muestra la siguiente fila (0..3) y retorna sin esperar; la fila queda
+  // encendida hasta la próxima llamada. Es lo que usa startAutoRefresh().
+  // En escala de grises cada llamada muestra un plano de la fila y devuelve su peso
+  // (2^plano): la ranura debería durar peso / (2^bits - 1) de la ranura de fila.
+  uint8_t refreshRow();
+
+  // Sincronía con el refresco. vsync = inicio de un ciclo de 4 filas, el único punto
+  // donde el refresco toma un frame nuevo: lo publicado nunca aparece a mitad de ciclo.
+  // present() publica como update(), pero solo cuando el refresco ya tomó el frame
+  // anterior: espera hasta timeoutMs y, si sigue pendiente, no construye nada y
+  // devuelve false (lo dibujado queda para el próximo present()). Así la animación
+  // avanza al ritmo de los frames mostrados y no se arman frames que nunca se ven.
+  // timeoutMs = 0 no espera (refresh() en el mismo hilo).
+  typedef void (*VSyncCallback)(uint32_t frame, void* arg);
+  bool present(uint32_t timeoutMs = 0);
+  bool framePending() const;                       // publicado y todavía no tomado
+  uint32_t frameCount() const { return _vsyncCount.load(std::memory_order_relaxed); }  // ciclos de scan empezados
+  // Número de publicación (1, 2, ... por cada update()/present() que armó un frame)
+  // del frame que está en los LEDs.
+  uint32_t shownFrame() const { return _shownSeq.load(std::memory_order_relaxed); }
+  // Bloquea hasta el próximo vsync. Con auto-refresh en el ESP32 el task duerme en
+  // un semáforo de la librería (no toca sus notificaciones); si no, sondea
+  // frameCount(). false si pasó timeoutMs.
+  bool waitForVSync(uint32_t timeoutMs = 100);
+  // Se llama desde el refresco (task de auto-refresh o quien llame refresh()/
+  // refreshRow()) en cada vsync, con frameCount(). Tiene que ser muy corto.
+  void onVSync(VSyncCallback cb, void* arg = nullptr) { _vsyncArg = arg; _vsyncCb = cb; }
+
+  // Cola de frames con hora de salida. queueFrame(atUs) arma lo dibujado igual que
+  // update() pero, en lugar de publicarlo, lo copia ya codificado a la cola; el
+  // refresco lo muestra en el primer vsync con micros() >= atUs, sin pasar por el
+  // hilo de dibujo. Si en un vsync vencieron varios se muestra el último y los
+  // otros cuentan como dropped. El último frame de la cola sigue en pantalla hasta
+  // el próximo vencido o hasta que update()/present() publiquen uno en vivo. Lo
+  // encolado queda pendiente para el vivo: el próximo update() lo publica.
+  // depth = 1..HUB12_FRAME_QUEUE_MAX (0 = sin cola), solo antes de begin().
+  // RAM: depth x scan (y stream SPI o multi-cadena).
+  bool setFrameQueue(uint8_t depth);
+  uint8_t frameQueueDepth() const { return _qDepth; }
+  bool queueFrame(uint32_t atUs);   // false: cola llena (o sin cola)
+  uint8_t queuedFrames() const;     // ocupados, incluido el que se muestra
+  void clearFrameQueue();           // desde el próximo vsync se vuelve al frame en vivo
+  HUB12QueueStats getQueueStats() const;
+  void resetQueueStats();
+
+  // Páginas: bakePage() arma lo dibujado igual que update() y guarda una copia en
+  // formato scan (rle = true la comprime con PackBits); devuelve el número de
+  // página o -1 (sin lugar o sin memoria). showPage() la copia/descomprime al scan
+  // libre y la publica, sin buildScan(). El framebuffer no cambia: la página
+  // queda hasta el próximo update() con cambios (invalidate() + update() vuelve
+  // a lo dibujado). En modo nativo la página pasa a ser lo dibujado. Como en
+  // queueFrame(), lo dibujado sigue pendiente: el próximo update() lo publica.
+  int bakePage(bool rle = false);
+  bool showPage(uint8_t page);
+  void freePage(uint8_t page);
+  void freePages();
+  uint8_t pageCount() const;          // páginas guardadas
+  uint32_t pageBytes(uint8_t page) const;   // RAM de la página (0 = libre)
+  uint32_t pageRawBytes() const { return _scanBytes * _planes; }   // sin RLE
+
+  // Lista de reproducción: páginas con su duración. playlistUpdate() va en loop():
+  // un millis() y, al vencer la duración, showPage() de la siguiente (en círculo).
+  bool playlistAdd(uint8_t page, uint16_t ms);
+  void playlistClear();
+  bool playlistUpdate();              // true si cambió de página
+  int playlistCurrent() const { return _plCount ? _plPos : -1; }
+
   // Doble buffer de dibujo (front/back framebuffer)
   void setDoubleBuffer(bool enable = true);
   bool isDoubleBuffer() const;
   void swapBuffers(bool copyFrontToBack = false);
 
+  // Modo nativo: se dibuja directo en orden de scan HUB12 (sin framebuffer lineal).
+  // update() solo publica el buffer (swap) y copia las filas tocadas al nuevo back.
+  // refresh() ya no reconstruye: hay que llamar update(). Ignora setDoubleBuffer().
+  // Solo antes de begin() (o después de end()); devuelve false si ya está iniciado.
+  bool setPanelNative(bool enable = true);
+  bool isPanelNative() const { return _native; }
+
+  // Salida por SPI+DMA: CLK=SCLK, DATA=MOSI (modo 0, MSB primero). Cada update()
+  // deja las 4 filas codificadas para DMA y refresh/refreshRow solo lanzan la
+  // transferencia; LAT, OE, A y B siguen por GPIO. Solo antes de begin().
+  bool setSpiOutput(bool enable = true, uint32_t clockHz = 10000000);
+  bool isSpiOutput() const { return _spiOut; }
+
+  // Escala de grises por BCM (binary code modulation): bits = 2..4 (1 = monocromo).
+  // El framebuffer pasa a bits planos de 1bpp y el scan a un juego por plano; el
+  // plano k se muestra 2^k unidades (unidad = tiempo ON / (2^bits - 1)), así que el
+  // nivel máximo brilla como un pixel encendido en monocromo. Solo antes de begin();
+  // no compatible con setPanelNative(). RAM de framebuffer y scan x bits.
+  bool setGrayscale(uint8_t bits);
+  uint8_t grayscaleBits() const { return _planes; }
+  uint8_t maxLevel() const { return (uint8_t)((1u << _planes) - 1); }
+  // Nivel con el que las primitivas dibujan 'on' (off = 0). Por defecto maxLevel();
+  // en monocromo no tiene efecto.
+  void setDrawLevel(uint8_t level) {
+    _drawLevel = (_planes == 1) ? 1 : (level > maxLevel() ? maxLevel() : level);
+  }
+  uint8_t drawLevel() const { return _drawLevel; }
+  uint8_t getPixelLevel(int x, int y) const;
+  // Un byte por pixel (0..255, se escala a 0..maxLevel()); 0 es transparente.
+  // Para glifos antialias o degradados. Respeta setClipRect().
+  void drawGrayBitmap(int x, int y, const uint8_t* bmp, int w, int h);
+
+  // Codifica scan -> stream SPI (DATA activo LOW: bit 1 = LED apagado).
+  // Un byte del stream = 8 flancos de CLK, en el orden del shift.
+  static void encodeSpiStream(const uint8_t* scan, uint8_t* out, uint32_t bytes);
+
+  // Último scan publicado por update()/showPage(), en el formato de 1.0.0 (fila r,
+  // paneles en orden de cadena, 16 bytes MSB primero); el plano k va en
+  // publishedScan() + k * scanBytes(). Solo lectura, para verificar o volcar.
+  const uint8_t* publishedScan() const { return _scan[_tbLast]; }
+  uint32_t scanBytes() const { return _scanBytes; }
+
+// periodUs = ciclo de 4 filas. El timer carga una fila por tick y otro timer
+// apaga OE al cumplirse _onTimeUs: el brillo ya no consume CPU. Si la ranura
+// de fila no cubre _onTimeUs más el shift, el periodo se estira (como en 1.0.0).
 bool startAutoRefresh(uint32_t periodUs = 500); // 500us = buen punto de partida
 void stopAutoRefresh();
 bool isAutoRefresh() const;
 
+// Instrumentación (apagada por defecto). Con todo activo cuesta 2 lecturas de
+// micros() por refresh/build; getStats() calcula los promedios.
+void setStatsEnabled(bool enable = true) { _statsOn = enable; }
+bool isStatsEnabled() const { return _statsOn; }
+HUB12Stats getStats() const;
+void resetStats();
+
 private:
+  // Variante con geometría fija: buffers estáticos y build especializado.
+  template <uint8_t, uint8_t, HUB12Layout, uint8_t> friend class HUB12;
+  typedef void (*BuildRowsFn)(HUB12_1DATA& d, uint8_t buf, const uint8_t* src);
+  const HUB12Storage* _storage = nullptr;
+  BuildRowsFn _buildRowsFn = nullptr;
+  uint8_t* takeBuffer(uint8_t* fixed, uint32_t bytes);
+  bool isStorage(const void* p) const;
+  static const uint8_t* rev8Table();
 
 #if defined(ESP32)
   esp_timer_handle_t _arTimer = nullptr;
-  bool _arEnabled = false;
+  volatile bool _arEnabled = false;   // lo lee el task en cada despertar
   uint32_t _arPeriodUs = 500;
+  uint32_t _arReqUs = 500;     // periodo pedido a startAutoRefresh() (_arPeriodUs puede ser mayor)
+  int64_t _arDueUs = 0;        // escala de grises: fin de la ranura de plano en curso
+  uint32_t arPeriodFor(uint32_t periodUs) const;
+  void arRetime();
   static void _arTimerCb(void* arg);
+  esp_timer_handle_t _oeTimer = nullptr;  // one-shot: fin del tiempo ON de la fila
+  static void _oeTimerCb(void* arg);
   TaskHandle_t _arTask = nullptr;
   static void _arTaskFn(void* arg);
+  // El task lo da al despertar con _arEnabled == false: desde ahí ya no toca los
+  // timers y se pueden borrar. arPark() apaga y espera ese aviso.
+  SemaphoreHandle_t _arParked = nullptr;
+  void arPark();
 #endif
 
-#if defined(ESP32)
-  portMUX_TYPE _scanMux = portMUX_INITIALIZER_UNLOCKED;
-#endif
-
-// Estado marquesina
-bool _mqEnabled = false;
-int16_t _mqX0=0, _mqY0=0, _mqW=0, _mqH=0;
-int16_t _mqX=0;
-int16_t _mqTextW=0;
-uint8_t _mqSpacing=1;
-uint16_t _mqStepMs=40;
-unsigned long _mqLast=0;
-const char* _mqText=nullptr;
+// Estado marquesina (marqueeStart/marqueeTick)
+Marquee _mq;
+// Ventanas del gestor (marqueeAdd/marqueeUpdate): se reservan en el primer
+// marqueeAdd(); quien no usa el gestor no paga sus HUB12_MAX_MARQUEES ventanas
+Marquee* _mqs = nullptr;
 
 bool _clipEnabled = false;
 int16_t _clipX0 = 0, _clipY0 = 0, _clipX1 = 0, _clipY1 = 0; // [x0,y0]..[x1,y1] inclusive
 
 const uint8_t* _font = nullptr;
 
+// Header de _font cacheado en setFont()
+const uint8_t* _fontData = nullptr;   // primer byte de datos de glifos
+uint8_t _fontW = 0, _fontH = 0, _fontFirst = 0, _fontCount = 0;
+uint8_t _fontBytesPerCol = 1;
+bool _fontVar = false;                // ancho variable (size != 0)
+const HUB12Glyph* _glyphs = nullptr;  // índice en uso (solo ancho variable)
+HUB12Glyph* _glyphsOwn = nullptr;     // índice armado por setFont() (se libera)
+
+// Atlas: filas de _atlasStride bytes, glifo i en i*_fontH filas
+bool _atlasOn = false;
+const uint8_t* _atlas = nullptr;
+uint8_t* _atlasOwn = nullptr;
+uint8_t _atlasStride = 0;
+
+inline bool glyph(uint8_t uc, uint32_t& ofs, uint8_t& w) const;
+uint32_t glyphRow(uint8_t idx, uint32_t ofs, uint8_t w, uint8_t row) const;
+static uint8_t glyphAtlasStride(const uint8_t* font);
+inline uint8_t glyphAdvance(uint8_t uc) const;
+
 // Estado Print/cursor
 int16_t _cx = 0;
 int16_t _cy = 0;
@@ -225,22 +635,135 @@ bool    _tcolor = true;
   uint8_t* _fb2 = nullptr;         // segundo buffer (solo si doble buffer)
   uint32_t _fbBytes = 0;
   bool _doubleBuffer = false;
+  bool _native = false;            // _fb apunta al scan inactivo (orden HUB12)
+  // Escala de grises: _planes planos de _fbBytes seguidos (plano k = bit k del nivel).
+  // El scan igual: plano k en scan + k*_scanBytes.
+  uint8_t _planes = 1;
+  uint8_t _drawLevel = 1;
+
+
+  // Triple buffer de scan sin locks. Productor: update() (arma en _tbBack).
+  // Consumidor: refresh()/refreshRow()/task (muestra _tbFront). _tbMid es el
+  // buffer intercambiado con una sola operación atómica; kTbFresh marca que tiene
+  // un frame publicado que el consumidor todavía no tomó.
+  // Los índices 3.. son los frames de la cola (kTbSlots + i).
+  static const uint32_t kTbFresh = 4;
+  static const uint8_t kTbSlots = 3;
+  static const uint8_t kScanBufs = kTbSlots + HUB12_FRAME_QUEUE_MAX;
+  uint8_t* _scan[kScanBufs] = {};
+  uint8_t _tbBack = 2;
+  volatile uint8_t _tbFront = 0;
+  volatile uint8_t _showBuf = 0;   // el que está en los LEDs (_tbFront o un frame de la cola)
+  uint8_t _tbLast = 0;             // último publicado (lado productor: rowLit)
+  std::atomic<uint32_t> _tbMid{1};
+  // Frames: _bufSeq[i] = número de publicación armado en _scan[i].
+  uint32_t _pubSeq = 0;
+  uint32_t _bufSeq[kScanBufs] = {};
+  // Escritos solo por el refresco; atómicos para leerlos desde el hilo de dibujo.
+  std::atomic<uint32_t> _shownSeq{0};
+  std::atomic<uint32_t> _vsyncCount{0};
+  VSyncCallback _vsyncCb = nullptr;
+  void* _vsyncArg = nullptr;
+#if defined(ESP32)
+  SemaphoreHandle_t _vsyncSem = nullptr;   // waitForVSync() con auto-refresh
+  volatile bool _vsyncWaiting = false;
+#endif
 
-
-    uint8_t* _scanA = nullptr;
-  uint8_t* _scanB = nullptr;
-  volatile uint8_t* _scanActive = nullptr;  // doble buffer scan
+  // Cola de frames: anillo SPSC de _qDepth frames en _scan[kTbSlots + n % _qDepth].
+  // _qTail lo avanza el productor (queueFrame), _qHead el refresco; el frame en
+  // pantalla (_qShowing) sigue ocupando su lugar hasta que se suelta.
+  uint8_t _qDepth = 0;
+  uint32_t _qDue[HUB12_FRAME_QUEUE_MAX] = {};
+  std::atomic<uint32_t> _qHead{0};
+  std::atomic<uint32_t> _qTail{0};
+  std::atomic<uint32_t> _qFlushTo{0};   // clearFrameQueue(): soltar todo lo anterior
+  bool _qShowing = false;
+  uint32_t _qPrevVs = 0;               // micros() del vsync anterior
+  uint32_t _qQueued = 0, _qFull = 0;   // lado productor
+  std::atomic<uint32_t> _qShown{0}, _qDropped{0}, _qUnderruns{0}, _qMaxLate{0};
+
+  // Páginas y lista de reproducción: las tablas se reservan con la primera
+  // bakePage()/playlistAdd() y se sueltan en freePages()/playlistClear()
+  HUB12Page* _pages = nullptr;         // HUB12_MAX_PAGES
+  struct PlaylistEntry { uint8_t page; uint16_t ms; };
+  PlaylistEntry* _pl = nullptr;        // HUB12_MAX_PLAYLIST
+  uint8_t _plCount = 0;
+  uint8_t _plPos = 0;
+  bool _plStarted = false;
+  unsigned long _plLast = 0;
   uint32_t _bytesPerR = 0;       // 16 * panelsTotal
   uint32_t _scanBytes = 0;
 
+  // Salida SPI: stream ya codificado para cada scan buffer (_tx[i] <-> _scan[i])
+  bool _spiOut = false;
+  uint32_t _spiHz = 10000000;
+  uint8_t* _tx[kScanBufs] = {};
+#if defined(ESP32)
+  spi_device_handle_t _spi = nullptr;
+#endif
+
+  // Multi-cadena: stream "bit-sliced", 1 byte por flanco de CLK (bit c = cadena c,
+  // 1 = LED encendido). _slice[i] <-> _scan[i]. _sliceLut: byte -> máscara de DATA en LOW.
+  uint8_t _chains = 1;
+  int _dataPins[HUB12_MAX_CHAINS];
+  uint8_t* _slice[kScanBufs] = {};
+  uint32_t* _sliceLut = nullptr;
+  uint32_t _dataMask = 0;           // todos los DATA (mismo banco)
+  bool _dataHiBank = false;
+
+  // Tablas del conversor framebuffer -> scan
+  HUB12PanelMap* _panelMap = nullptr;  // uno por panel, en orden de cadena
+  uint16_t _scanLut[64];               // [r*16 + byteEnPanel] -> offset en fb relativo al panel
+
   volatile bool _dirty = true;
+  // queueFrame()/bakePage() dejaron el back armado sin publicarlo: update() lo
+  // publica sin reconstruir. Cualquier publishScan() lo baja.
+  bool _needsPublish = false;
+
+  // DirtyRect: por panel (orden framebuffer), bit ly = fila local 0..15 modificada.
+  // _dirtyStale[i*paneles + p]: filas que cambiaron desde que se armó _scan[i]
+  // (cuando vuelve como back puede estar uno o dos frames atrás).
+  uint16_t* _dirtyRows = nullptr;
+  uint16_t* _dirtyStale = nullptr;
   uint16_t _onTimeUs = 800;
+  volatile uint8_t _rowNext = 0;   // próxima fila de refreshRow()
+  volatile uint8_t _planeNext = 0; // próximo plano de esa fila (escala de grises)
+
+  // Limitador: LEDs encendidos por [scan 0..2][plano][fila][panel en orden de cadena]
+  // (solo se recuentan los bloques que buildScan() rehace; _litPlane[buf][k*4+r]
+  // sigue la suma por diferencia). _litRow = suma por fila ponderada por plano
+  // (lit_k << k); _litBlank bit r*4+k = fila r, plano k vacío. Los frames de la
+  // cola solo llevan _litRow/_litBlank (copiados al encolar).
+  uint8_t* _litCnt = nullptr;
+  uint32_t _litPlane[3][16] = {};
+  uint32_t _litRow[kScanBufs][4] = {};
+  uint16_t _litBlank[kScanBufs] = {};   // begin() los deja en 0xFFFF
+  uint32_t _powerLeds = 0;
+  uint16_t _powerMaxUs = 0;
+  volatile uint32_t _rowOnUs = 0;
+
+  // Estadísticas (minimos en UINT32_MAX hasta la primera muestra)
+  bool _statsOn = false;
+  HUB12Stats _stats;
+  uint32_t _statRefreshMin = UINT32_MAX, _statBuildMin = UINT32_MAX;
+  unsigned long _statLastWake = 0;   // micros() del último despertar del task
 
   // Fast GPIO pins
   HUB12FastPin _fOE, _fA, _fB, _fCLK, _fLAT, _fDATA;
 
+  inline uint32_t nativeIndex(int x, int y, uint8_t& mask) const;
   inline bool fbGet(int x, int y) const;
   inline void fbSet(int x, int y, bool on);
+  inline void fbSetLevel(int x, int y, uint8_t level);
+  uint8_t planeRop(RasterOp op, uint8_t plane) const;
+  inline void fbSpan(int y, int x0, int x1, bool on);   // tramo horizontal recortado
+  inline void fbVSpan(int x, int y0, int y1, bool on);  // tramo vertical recortado
+  void markDirty(int x0, int y0, int x1, int y1); // rect inclusivo, ya recortado a pantalla
+  void markAllDirty();
+  bool clipBox(int& x0, int& y0, int& x1, int& y1) const;
+  // plane >= 0: solo ese plano y op tal cual (copias crudas entre framebuffers).
+  void blitRaw(int x, int y, const uint8_t* src, int w, int h, RasterOp op,
+               uint16_t srcStride, bool lsbFirst, bool useClip, int8_t plane = -1);
 
   // Mapeo interno del panel 32x16 1-DATA (calibrado)
   static int xyToBitIndexLocal(int x, int y);
@@ -248,7 +771,36 @@ bool    _tcolor = true;
   // Mapeo global -> panelIdx + coords locales (serpentina opcional)
   void mapGlobalToChain(int gx, int gy, uint8_t& panelIdx, int& lx, int& ly) const;
 
+  void initScanTables();
   void buildScan();
+  void presentNative();
+  uint8_t acquireScan();
+  void publishScan();
+  void markStale(uint8_t buf);
+  void signalVSync();
+  uint8_t beginCycle();
+  uint8_t pickQueued(uint8_t live, bool fresh);
+  void renderBack();
+  void buildRows(uint8_t buf, const uint8_t* src);
+  void countBlock(uint8_t buf, uint8_t k, uint8_t r, uint16_t i, const uint8_t* block);
+  static uint32_t rleEncode(const uint8_t* src, uint32_t n, uint8_t* out);
+  static void rleDecode(const uint8_t* src, uint32_t n, uint8_t* out);
+  void shiftRow(uint8_t buf, uint8_t r, uint8_t plane = 0);
+  uint32_t planeOnUs(uint32_t us, uint8_t plane) const;
+  uint8_t* litCounts(uint8_t buf) const;
+  inline void countLit(uint8_t buf, uint8_t k, uint8_t r, uint16_t i, const uint8_t* block);
+  void sumLit(uint8_t buf);
+  uint32_t rowOnUs(uint8_t buf, uint8_t r, uint32_t us) const;
+  void encodeOutput(uint8_t buf);
+  void encodeSlices(const uint8_t* scan, uint8_t* out) const;
+  bool spiBegin();
+  void spiEnd();
+  void statRefresh(uint32_t us);
+  void statBuild(uint32_t us);
+  void statLock(uint32_t cycles);
+#if defined(ESP32)
+  void statWake(uint32_t notified);
+#endif
 
   // Low-level (fast)
   inline void pulseCLK();
@@ -256,3 +808,6 @@ bool    _tcolor = true;
   inline void setRow(uint8_t r);
   inline void writeData(bool on);
 };
+
+// Variante con geometría fija en compilación
+#include "HUB12.h"
@@ -0,0 +1,188 @@
+#include "HUB12_host.h"
+#if !defined(ARDUINO)
+#include <atomic>
+#include <chrono>
+#include <stdarg.h>
+
+// ---------- Tiempo / pines ----------
+// Lo acumulado por delay()/delayMicroseconds(); atómico: en los tests lo avanza el
+// hilo de refresco mientras otro lee millis()
+static std::atomic<unsigned long long> s_virtualUs(0);
+static std::atomic<bool> s_realClock(true);
+
+static unsigned long long hostNowUs() {
+  if (!s_realClock) return s_virtualUs;
+  static const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  unsigned long long real = (unsigned long long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - t0).count();
+  return real + s_virtualUs;
+}
+
+void pinMode(int, int) {}
+unsigned long micros() { return (unsigned long)hostNowUs(); }
+unsigned long millis() { return (unsigned long)(hostNowUs() / 1000ULL); }
+void delay(unsigned long ms) { s_virtualUs += (unsigned long long)ms * 1000ULL; }
+void delayMicroseconds(unsigned int us) { s_virtualUs += us; }
+void yield() {}
+void hostSetRealClock(bool on) { s_realClock = on; }
+
+// ---------- Print ----------
+size_t Print::write(const uint8_t* buf, size_t n) {
+  size_t k = 0;
+  while (n--) k += write(*buf++);
+  return k;
+}
+
+size_t Print::print(long v) {
+  char b[24];
+  snprintf(b, sizeof(b), "%ld", v);
+  return write(b);
+}
+
+size_t Print::print(unsigned long v) {
+  char b[24];
+  snprintf(b, sizeof(b), "%lu", v);
+  return write(b);
+}
+
+size_t Print::print(double v, int digits) {
+  char b[48];
+  snprintf(b, sizeof(b), "%.*f", digits, v);
+  return write(b);
+}
+
+HUB12HostSerial Serial;
+HUB12HostPanel HUB12Host;
+
+void hub12HostGpioWrite(bool hiBank, bool set, uint32_t mask) {
+  HUB12Host.gpioWrite(hiBank, set, mask);
+}
+
+// ---------- Panel virtual ----------
+HUB12HostPanel::~HUB12HostPanel() {
+  release();
+}
+
+void HUB12HostPanel::release() {
+  if (_shift) { free(_shift); _shift = nullptr; }
+  if (_latch) { free(_latch); _latch = nullptr; }
+  if (_lit)   { free(_lit);   _lit = nullptr; }
+  if (_onUs)  { free(_onUs);  _onUs = nullptr; }
+}
+
+void HUB12HostPanel::attach(int oe, int a, int b, int clk, int lat, const int* data, uint8_t chains,
+                            uint8_t panelsX, uint8_t panelsY, bool serpentine) {
+  release();
+
+  _oe = oe; _a = a; _b = b; _clk = clk; _lat = lat;
+  _chains = (chains < 1) ? 1 : (chains > 8 ? 8 : chains);
+  for (uint8_t c = 0; c < _chains; c++) _data[c] = data[c];
+  _panelsX = panelsX; _panelsY = panelsY; _serp = serpentine;
+  _w = 32 * panelsX;
+  _h = 16 * panelsY;
+
+  _bitsPerChain = 128u * ((uint32_t)panelsX * panelsY / _chains);
+  _shift = (uint8_t*)calloc((size_t)_bitsPerChain * _chains, 1);
+  _latch = (uint8_t*)calloc((size_t)_bitsPerChain * _chains, 1);
+  _lit   = (uint8_t*)calloc((size_t)_w * _h, 1);
+  _onUs  = (uint32_t*)calloc((size_t)_w * _h, sizeof(uint32_t));
+  _shiftPos = 0;
+  _level = 0;
+  _oeOn = false;
+  _clocks = _latches = _rowsShown = 0;
+}
+
+void HUB12HostPanel::clearImage() {
+  if (_lit)  memset(_lit, 0, (size_t)_w * _h);
+  if (_onUs) memset(_onUs, 0, (size_t)_w * _h * sizeof(uint32_t));
+  _clocks = _latches = _rowsShown = 0;
+  if (_oeOn) _oeT0 = micros();
+}
+
+bool HUB12HostPanel::lit(int x, int y) const {
+  if (!_lit || x < 0 || y < 0 || x >= (int)_w || y >= (int)_h) return false;
+  return _lit[(uint32_t)y * _w + x] != 0;
+}
+
+uint32_t HUB12HostPanel::onTimeUs(int x, int y) const {
+  if (!_onUs || x < 0 || y < 0 || x >= (int)_w || y >= (int)_h) return 0;
+  return _onUs[(uint32_t)y * _w + x];
+}
+
+// Recorre los pixeles encendidos de la fila r según el latch actual.
+// Bit k del stream de una cadena -> panel k/128 de esa cadena, bit local k%128
+// (inverso de xyToBitIndexLocal + mapGlobalToChain de HUB12_1DATA).
+void HUB12HostPanel::forEachLit(uint8_t r, bool mark, uint32_t addUs) {
+  uint32_t panelsPerChain = _bitsPerChain / 128;
+
+  for (uint8_t c = 0; c < _chains; c++) {
+    const uint8_t* bits = _latch + (size_t)c * _bitsPerChain;
+    for (uint32_t k = 0; k < _bitsPerChain; k++) {
+      if (!bits[k]) continue;
+
+      uint32_t p = c * panelsPerChain + k / 128;
+      uint8_t bit = k & 127;
+      int lx = (bit >> 5) * 8 + (bit & 7);
+      int ly = (3 - ((bit >> 3) & 3)) * 4 + r;
+
+      int py = p / _panelsX;
+      int px = p % _panelsX;
+      if (_serp && (py & 1)) { px = _panelsX - 1 - px; lx = 31 - lx; }
+
+      uint32_t idx = (uint32_t)(py * 16 + ly) * _w + (uint32_t)(px * 32 + lx);
+      if (mark) _lit[idx] = 1;
+      _onUs[idx] += addUs;
+    }
+  }
+}
+
+void HUB12HostPanel::gpioWrite(bool hiBank, bool set, uint32_t mask) {
+  if (!_shift || !_enabled) return;
+
+  uint64_t m = hiBank ? ((uint64_t)mask << 32) : (uint64_t)mask;
+  uint64_t old = _level;
+  if (set) _level |= m;
+  else     _level &= ~m;
+  uint64_t rise = _level & ~old;
+
+  bool shownChanged = false;
+
+  if ((rise >> _clk) & 1) {
+    for (uint8_t c = 0; c < _chains; c++) {
+      // DATA activo LOW: LOW = LED encendido
+      _shift[(size_t)c * _bitsPerChain + _shiftPos] = level(_data[c]) ? 0 : 1;
+    }
+    _shiftPos = (_shiftPos + 1) % _bitsPerChain;
+    _clocks++;
+  }
+
+  if ((rise >> _lat) & 1) {
+    // El latch toma los últimos _bitsPerChain bits, del más antiguo al más nuevo
+    for (uint8_t c = 0; c < _chains; c++) {
+      const uint8_t* s = _shift + (size_t)c * _bitsPerChain;
+      uint8_t* l = _latch + (size_t)c * _bitsPerChain;
+      for (uint32_t k = 0; k < _bitsPerChain; k++) l[k] = s[(_shiftPos + k) % _bitsPerChain];
+    }
+    _latches++;
+    shownChanged = true;
+  }
+
+  uint8_t row = (uint8_t)(level(_a) | (level(_b) << 1));
+  bool oe = level(_oe);   // OE activo HIGH
+  if (_oeOn && row != _rowOn) shownChanged = true;
+
+  if (_oeOn && (!oe || shownChanged)) {
+    unsigned long now = micros();
+    forEachLit(_rowOn, false, (uint32_t)(now - _oeT0));
+    _oeOn = false;
+  }
+  if (oe && !_oeOn) {
+    _oeOn = true;
+    _rowOn = row;
+    _oeT0 = micros();
+    _rowsShown++;
+    forEachLit(row, true, 0);
+  }
+}
+
+#endif
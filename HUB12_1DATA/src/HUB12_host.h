@@ -0,0 +1,143 @@
+#pragma once
+// Build en PC (Linux/macOS/Windows) sin Arduino: reemplazo mínimo de Arduino.h/Print.h
+// y un panel HUB12 virtual que recibe las escrituras de GPIO de la librería.
+// Solo se usa si ARDUINO no está definido; en el ESP32 este archivo no hace nada.
+//
+//   g++ -std=c++11 -O2 -Isrc src/HUB12_1DATA.cpp src/HUB12_host.cpp main.cpp
+//
+#if !defined(ARDUINO)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PROGMEM
+  #define PROGMEM
+#endif
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+
+#define INPUT  0x01
+#define OUTPUT 0x03
+#define LOW    0
+#define HIGH   1
+
+// Tiempo: reloj real + lo "esperado" con delay()/delayMicroseconds(), que no duermen.
+void pinMode(int pin, int mode);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+// false: micros()/millis() solo avanzan con delay()/delayMicroseconds(); los tiempos
+// que mide el panel virtual quedan exactos (tests). Por defecto true.
+void hostSetRealClock(bool on);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t n);
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v) { return print((long)v); }
+  size_t print(unsigned int v) { return print((unsigned long)v); }
+  size_t print(long v);
+  size_t print(unsigned long v);
+  size_t print(double v, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+};
+
+// Serial -> stdout
+class HUB12HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() { fflush(stdout); }
+  operator bool() const { return true; }
+};
+extern HUB12HostSerial Serial;
+
+// Destino de gpioSet/gpioClr en PC (equivale a GPIO.out_w1ts / out_w1tc)
+void hub12HostGpioWrite(bool hiBank, bool set, uint32_t mask);
+
+// ---------- Panel HUB12 virtual ----------
+// Emula los registros de desplazamiento (uno por cadena DATA), el latch y la
+// selección de fila 1/4 (A,B). Cada vez que OE enciende una fila marca los pixeles
+// encendidos y, al apagarse, les suma el tiempo ON (micros()).
+// begin() de HUB12_1DATA lo conecta solo con su cableado y geometría.
+class HUB12HostPanel {
+public:
+  ~HUB12HostPanel();
+
+  void attach(int oe, int a, int b, int clk, int lat, const int* data, uint8_t chains,
+              uint8_t panelsX, uint8_t panelsY, bool serpentine);
+
+  uint16_t width()  const { return _w; }
+  uint16_t height() const { return _h; }
+
+  // Imagen acumulada desde clearImage(): pixel encendido al menos una vez.
+  void clearImage();
+  bool lit(int x, int y) const;
+  uint32_t onTimeUs(int x, int y) const;   // tiempo ON acumulado del pixel
+
+  // false: las escrituras se ignoran (backend nulo, p.ej. para medir solo la librería)
+  void setEnabled(bool enabled) { _enabled = enabled; }
+  bool isEnabled() const { return _enabled; }
+
+  bool level(int pin) const { return (pin >= 0 && pin < 64) ? ((_level >> pin) & 1) : false; }
+
+  // Contadores (también se ponen en 0 con clearImage())
+  uint32_t clocks() const  { return _clocks; }
+  uint32_t latches() const { return _latches; }
+  uint32_t rowsShown() const { return _rowsShown; }
+
+  void gpioWrite(bool hiBank, bool set, uint32_t mask);
+
+private:
+  int _oe = -1, _a = -1, _b = -1, _clk = -1, _lat = -1;
+  int _data[8];
+  uint8_t _chains = 0;
+  uint8_t _panelsX = 0, _panelsY = 0;
+  bool _serp = false;
+  uint16_t _w = 0, _h = 0;
+
+  bool _enabled = true;
+  uint64_t _level = 0;
+  uint32_t _bitsPerChain = 0;   // 128 * paneles por cadena
+  uint8_t* _shift = nullptr;    // [cadena][bit], circular
+  uint8_t* _latch = nullptr;    // [cadena][bit], bit 0 = primero desplazado
+  uint32_t _shiftPos = 0;
+
+  uint8_t* _lit = nullptr;
+  uint32_t* _onUs = nullptr;
+  bool _oeOn = false;
+  uint8_t _rowOn = 0;
+  unsigned long _oeT0 = 0;
+
+  uint32_t _clocks = 0, _latches = 0, _rowsShown = 0;
+
+  void release();
+  void forEachLit(uint8_t r, bool mark, uint32_t addUs);
+};
+
+extern HUB12HostPanel HUB12Host;
+
+#endif
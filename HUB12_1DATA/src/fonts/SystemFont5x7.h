@@ -88,7 +88,7 @@ static const uint8_t System5x7[] PROGMEM = {
   0x03,0x04,0x78,0x04,0x03, // Y
   0x61,0x51,0x49,0x45,0x43, // Z
   0x00,0x00,0x7F,0x41,0x41, // [
-  0x02,0x04,0x08,0x10,0x20, // \
+  0x02,0x04,0x08,0x10,0x20, // backslash
   0x41,0x41,0x7F,0x00,0x00, // ]
   0x04,0x02,0x01,0x02,0x04, // ^
   0x40,0x40,0x40,0x40,0x40, // _